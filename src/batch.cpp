@@ -0,0 +1,267 @@
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cstdint>
+#include <cctype>
+#include <algorithm>
+#include <memory>
+#include "batch.h"
+#include "stream.h"
+#include "gaussian.h"
+#include "median.h"
+#include "bilateral.h"
+#include "trace.h"
+#include "file_key.h"
+
+/////////////////// BATCH CONSTRUCTOR ///////////////////
+
+// @brief: Initializes the batch job with default values
+Batch::Batch(void) {
+  this->input = "";
+  this->output = "";
+  this->tracePath = "";
+  this->stream = false;
+  this->memoryReport = false;
+  this->memoryBudget = 0;
+  this->profile = SaveProfile::BALANCED;
+  this->resizeWidth = 0;
+  this->resizeHeight = 0;
+  this->resizeFilter = ResizeFilter::LANCZOS3;
+
+  // A job runs its pipeline once, so cached node outputs would never be reused
+  this->recipe.getPipeline().setCacheBudget(0);
+}
+
+/////////////////// BATCH PRIVATE METHODS ///////////////
+
+// @brief: Processes the image
+// @return: The process exit code
+int Batch::process(void) {
+  const bool resize = this->resizeWidth > 0 || this->resizeHeight > 0;
+
+  // Process the image in memory
+  if (!this->stream) {
+    this->recipe.load(this->input);
+    if (this->recipe.isLoaded()) this->recipe.apply();
+
+    // Images that do not fit in the memory budget are streamed instead, if the pipeline allows it
+    if (this->recipe.isOverBudget() && this->recipe.getPipeline().isStreamable() && !resize) {
+      std::cerr << "Streaming to stay within the memory budget" << std::endl;
+      this->stream = true;
+    }
+  }
+
+  // Stream the image row by row
+  if (this->stream) {
+    if (resize) {
+      std::cerr << "Resizing is not supported in streaming mode" << std::endl;
+      return 1;
+    }
+    StreamProcessor processor(this->recipe.getPipeline());
+    processor.setProfile(this->profile);
+    return processor.process(this->input, this->output) ? 0 : 1;
+  }
+
+  if (!this->recipe.isLoaded() || this->recipe.isOverBudget()) return 1;
+
+  // Resize last, filling in a missing side from the aspect ratio
+  if (resize) {
+    const double width = this->recipe.getWidth();
+    const double height = this->recipe.getHeight();
+    const int resizeWidth = this->resizeWidth > 0 ? this->resizeWidth : std::max(1, static_cast<int>(width * this->resizeHeight / height + 0.5));
+    const int resizeHeight = this->resizeHeight > 0 ? this->resizeHeight : std::max(1, static_cast<int>(height * this->resizeWidth / width + 0.5));
+    this->recipe.resize(resizeWidth, resizeHeight, this->resizeFilter);
+    if (this->recipe.isOverBudget()) return 1;
+  }
+  this->recipe.setPath(this->output);
+  return this->recipe.save(this->profile) ? 0 : 1;
+}
+
+/////////////////// BATCH METHODS ///////////////////////
+
+// @brief: Parses the command line into a batch job
+// Functions are added to the pipeline in the order they are given
+// @param `argc`: The number of arguments
+// @param `argv`: The arguments
+// @return: Whether the command line is valid
+bool Batch::parse(int argc, char* argv[]) {
+  std::vector<std::string> files;
+  Pipeline& pipeline = this->recipe.getPipeline();
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (arg == "--help") return false;
+    else if (arg == "--stream") this->stream = true;
+    else if (arg == "--trace" && hasValue) this->tracePath = argv[++i];
+    else if (arg == "--memory") this->memoryReport = true;
+    else if (arg == "--memory-budget" && hasValue) {
+      // A whole number of megabytes
+      std::string value = argv[++i];
+      char* end = nullptr;
+      unsigned long long megabytes = std::strtoull(value.c_str(), &end, 10);
+      if (value.empty() || !std::isdigit(static_cast<unsigned char>(value[0])) || *end != '\0' || megabytes > (SIZE_MAX >> 20)) {
+        std::cerr << "Invalid memory budget: " << value << std::endl;
+        return false;
+      }
+      this->memoryBudget = static_cast<size_t>(megabytes) << 20;
+    }
+    else if (arg == "--invert") pipeline.add(Operation(OperationType::INVERT));
+    else if (arg == "--grayscale") pipeline.add(Operation(OperationType::GRAYSCALE));
+    else if (arg == "--blur") pipeline.add(Operation(OperationType::BLUR));
+    else if (arg == "--sharpen") pipeline.add(Operation(OperationType::SHARPEN));
+    else if (arg == "--unsharp") pipeline.add(Operation(OperationType::UNSHARP));
+    else if ((arg == "--red" || arg == "--green" || arg == "--blue") && hasValue) {
+      // Consecutive gains share one RGB node
+      if (pipeline.size() == 0 || pipeline.getOperation(pipeline.size() - 1).type != OperationType::RGB) pipeline.add(Operation(OperationType::RGB));
+      Operation& rgb = pipeline.getOperation(pipeline.size() - 1);
+      float gain = std::strtof(argv[++i], nullptr);
+      if (arg == "--red") rgb.red = gain;
+      else if (arg == "--green") rgb.green = gain;
+      else rgb.blue = gain;
+    }
+    else if (arg == "--rotate" && hasValue) {
+      Operation rotate(OperationType::ROTATE);
+      rotate.angle = std::atoi(argv[++i]);
+      pipeline.add(rotate);
+    }
+    else if ((arg == "--radius" || arg == "--amount" || arg == "--threshold") && hasValue) {
+      // Consecutive settings share one unsharp mask node, and tune the one --unsharp just added
+      if (pipeline.size() == 0 || pipeline.getOperation(pipeline.size() - 1).type != OperationType::UNSHARP) pipeline.add(Operation(OperationType::UNSHARP));
+      Operation& unsharp = pipeline.getOperation(pipeline.size() - 1);
+      float value = std::strtof(argv[++i], nullptr);
+      if (arg == "--radius") unsharp.radius = std::clamp(value, GAUSSIAN_MIN_SIGMA, GAUSSIAN_MAX_SIGMA);
+      else if (arg == "--amount") unsharp.amount = std::clamp(value, 0.0f, UNSHARP_MAX_AMOUNT);
+      else unsharp.threshold = std::clamp(value, 0.0f, UNSHARP_MAX_THRESHOLD);
+    }
+    else if (arg == "--gaussian" && hasValue) {
+      Operation gaussian(OperationType::GAUSSIAN);
+      gaussian.sigma = std::clamp(std::strtof(argv[++i], nullptr), GAUSSIAN_MIN_SIGMA, GAUSSIAN_MAX_SIGMA);
+      pipeline.add(gaussian);
+    }
+    else if (arg == "--median" && hasValue) {
+      Operation median(OperationType::MEDIAN);
+      median.medianRadius = std::clamp(std::atoi(argv[++i]), 1, MEDIAN_MAX_RADIUS);
+      pipeline.add(median);
+    }
+    else if (arg == "--bilateral" && i + 2 < argc) {
+      Operation bilateral(OperationType::BILATERAL);
+      bilateral.spatial = std::clamp(std::strtof(argv[++i], nullptr), BILATERAL_MIN_SPATIAL, BILATERAL_MAX_SPATIAL);
+      bilateral.range = std::clamp(std::strtof(argv[++i], nullptr), BILATERAL_MIN_RANGE, BILATERAL_MAX_RANGE);
+      pipeline.add(bilateral);
+    }
+    else if (arg == "--resize" && hasValue) {
+      // <width>x<height>, where 0 keeps the aspect ratio
+      std::string value = argv[++i];
+      size_t x = value.find('x');
+      this->resizeWidth = std::max(0, std::atoi(value.c_str()));
+      this->resizeHeight = x == std::string::npos ? 0 : std::max(0, std::atoi(value.c_str() + x + 1));
+      if (x == std::string::npos || (this->resizeWidth == 0 && this->resizeHeight == 0)) {
+        std::cerr << "Invalid size: " << value << std::endl;
+        return false;
+      }
+    }
+    else if (arg == "--filter" && hasValue) {
+      std::string value = argv[++i];
+      if (value == "box") this->resizeFilter = ResizeFilter::BOX;
+      else if (value == "bilinear") this->resizeFilter = ResizeFilter::BILINEAR;
+      else if (value == "bicubic") this->resizeFilter = ResizeFilter::BICUBIC;
+      else if (value == "lanczos") this->resizeFilter = ResizeFilter::LANCZOS3;
+      else {
+        std::cerr << "Unknown resize filter: " << value << std::endl;
+        return false;
+      }
+    }
+    else if (arg == "--profile" && hasValue) {
+      std::string value = argv[++i];
+      if (value == "fastest") this->profile = SaveProfile::FASTEST;
+      else if (value == "balanced") this->profile = SaveProfile::BALANCED;
+      else if (value == "smallest") this->profile = SaveProfile::SMALLEST;
+      else {
+        std::cerr << "Unknown save profile: " << value << std::endl;
+        return false;
+      }
+    }
+    else if (arg.rfind("--", 0) == 0) {
+      std::cerr << "Unknown option: " << arg << std::endl;
+      return false;
+    }
+    else files.push_back(arg);
+  }
+
+  if (files.size() != 2) return false;
+  this->input = files[0];
+  this->output = files[1];
+  return true;
+}
+
+// @brief: Runs the batch job under its own memory budget and writes its memory report and trace if they were asked for
+// @return: The process exit code
+int Batch::run(void) {
+  MemoryTracker::get().setBudget(this->memoryBudget);
+  int code = this->process();
+  if (this->memoryReport) MemoryTracker::get().printReport(std::cout);
+  if (!this->tracePath.empty() && !Tracer::get().write(this->tracePath) && code == 0) code = 1;
+  return code;
+}
+
+// @brief: Runs every job of the command line, separated by --then, one after the other
+// Jobs run in one process, so the ones that read the same input share its decoded pixels through the decode cache
+// @param `argc`: The number of arguments
+// @param `argv`: The arguments
+// @return: The exit code of the first job that failed, or 0
+int Batch::runAll(int argc, char* argv[]) {
+  // Parse every job before running any, so that a typo in the last one does not leave half the outputs written
+  std::vector<std::unique_ptr<Batch>> jobs;
+  std::vector<char*> args = { argv[0] };
+  for (int i = 1; i <= argc; ++i) {
+    if (i < argc && std::strcmp(argv[i], "--then") != 0) {
+      args.push_back(argv[i]);
+      continue;
+    }
+    jobs.push_back(std::make_unique<Batch>());
+    if (!jobs.back()->parse(static_cast<int>(args.size()), args.data())) {
+      printUsage(argv[0]);
+      return 4;
+    }
+    args.resize(1);
+  }
+
+  // Only jobs whose input a later job reads again keep a decoded copy of it
+  std::vector<std::string> keys;
+  for (const std::unique_ptr<Batch>& job : jobs) keys.push_back(getFileKey(job->input));
+  for (size_t i = 0; i < jobs.size(); ++i) {
+    const bool reused = !keys[i].empty() && std::find(keys.begin() + i + 1, keys.end(), keys[i]) != keys.end();
+    jobs[i]->recipe.setCacheDecoded(reused);
+  }
+
+  int code = 0;
+  for (std::unique_ptr<Batch>& job : jobs) {
+    int result = job->run();
+    if (code == 0) code = result;
+    job.reset(); // Only the decode cache outlives a job
+  }
+  return code;
+}
+
+// @brief: Prints the command line usage
+// @param `program`: The name of the executable
+void Batch::printUsage(const char* program) {
+  std::cerr << "Usage: " << program << " [options] <input.png> <output.png> [--then [options] <input.png> <output.png>]..." << std::endl;
+  std::cerr << "Functions run in the order they are given." << std::endl;
+  std::cerr << "Jobs separated by --then run one after the other and decode an input they share once." << std::endl;
+  std::cerr << "  --invert, --grayscale, --blur, --sharpen  Add a function" << std::endl;
+  std::cerr << "  --red/--green/--blue <gain>               Scale a channel (0-1)" << std::endl;
+  std::cerr << "  --rotate <degrees>                        Rotate the image" << std::endl;
+  std::cerr << "  --gaussian <sigma>                        Gaussian blur (0.5-100 pixels)" << std::endl;
+  std::cerr << "  --unsharp                                 Unsharp mask" << std::endl;
+  std::cerr << "  --radius/--amount/--threshold <value>     Tune the unsharp mask (1 px, 1.0, 0 levels)" << std::endl;
+  std::cerr << "  --median <radius>                         Median filter (1-50 pixels)" << std::endl;
+  std::cerr << "  --bilateral <spatial> <range>             Edge-preserving smoothing (4-100 pixels, 4-255 levels)" << std::endl;
+  std::cerr << "  --resize <width>x<height>                 Resize the result last (0 keeps the aspect ratio)" << std::endl;
+  std::cerr << "  --filter <box|bilinear|bicubic|lanczos>   Choose the resize filter (lanczos)" << std::endl;
+  std::cerr << "  --profile <fastest|balanced|smallest>     Choose the save profile" << std::endl;
+  std::cerr << "  --stream                                  Process row by row in O(width) memory" << std::endl;
+  std::cerr << "  --trace <trace.json>                      Write a Chrome/Perfetto trace of the run" << std::endl;
+  std::cerr << "  --memory                                  Print the current and peak memory use" << std::endl;
+  std::cerr << "  --memory-budget <MB>                      Stream, or fail, instead of using more memory" << std::endl;
+}
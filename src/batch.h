@@ -0,0 +1,33 @@
+#pragma once
+
+#include <string>
+#include "image.h"
+
+class Batch {
+private:
+  /* Private Variables */
+  std::string input;
+  std::string output;
+  std::string tracePath;
+  bool stream;
+  bool memoryReport;
+  size_t memoryBudget; // 0 for none
+  SaveProfile profile;
+  int resizeWidth;  // 0 keeps the aspect ratio, or the size when both are 0
+  int resizeHeight;
+  ResizeFilter resizeFilter;
+  Image recipe;
+
+  /* Private Methods */
+  int process(void);
+
+public:
+  /* Constructor */
+  Batch(void);
+
+  /* Methods */
+  bool parse(int argc, char* argv[]);
+  int run(void);
+  static int runAll(int argc, char* argv[]);
+  static void printUsage(const char* program);
+};
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "bilateral.h"
+#include "filters.h"
+#include "parallel.h"
+#include "memory_tracker.h"
+
+/////////////////// BILATERAL HELPERS ///////////////////
+
+const int GRID_PADDING = 2; // Empty cells around the grid, which the blur reads past its edges
+
+// @brief: Returns the gray level of a pixel, which decides how far it is from its neighbours
+template <typename T>
+static float grayOf(const T* pixel, int colors) {
+  return colors >= 3 ? (static_cast<float>(pixel[0]) + pixel[1] + pixel[2]) / 3.0f : pixel[0];
+}
+
+// @brief: Blurs `count` contiguous cells with the taps [1 4 6 4 1] / 16 along one axis of the grid
+// The taps have a standard deviation of one cell. Every output is a multiply-add over five runs of
+// the input, which vectorizes.
+// @param `in`: The first input cell
+// @param `out`: The first output cell (must not alias `in`)
+// @param `count`: The number of values
+// @param `stride`: The distance between neighbours along the axis
+static void blurRun(const float* in, float* out, size_t count, size_t stride) {
+  const float* a = in - 2 * stride;
+  const float* b = in - stride;
+  const float* d = in + stride;
+  const float* e = in + 2 * stride;
+  for (size_t i = 0; i < count; ++i) out[i] = (a[i] + e[i] + 4.0f * (b[i] + d[i]) + 6.0f * in[i]) * (1.0f / 16.0f);
+}
+
+/////////////////// IMAGE FILTERS ///////////////////////
+
+// @brief: Smooths an image with a bilateral grid
+// Every pixel is added to the grid cell at its position divided by the spatial sigma and its gray
+// level divided by the range sigma (splat). The grid is blurred by one cell along each axis and every
+// pixel reads back the weighted average at its own cell, interpolated between the eight around it
+// (slice). Jobs own strips of grid rows and splat the few image rows that their blur reaches past
+// the strip themselves, so they never wait for each other.
+// @param `src`: The source pixels
+// @param `dst`: The destination pixels (must not alias `src`)
+// @param `width`, `height`: The image size
+// @param `channels`: The number of channels per pixel
+// @param `spatial`: The spatial sigma in pixels, clamped to [BILATERAL_MIN_SPATIAL, BILATERAL_MAX_SPATIAL]
+// @param `range`: The range sigma in 8-bit levels, clamped to [BILATERAL_MIN_RANGE, BILATERAL_MAX_RANGE]
+template <typename T>
+void bilateralPixels(const T* src, T* dst, int width, int height, int channels, float spatial, float range) {
+  if (width <= 0 || height <= 0) return;
+  const float max = SampleTraits<T>::max;
+  const float cell = std::clamp(spatial, BILATERAL_MIN_SPATIAL, BILATERAL_MAX_SPATIAL);
+  const float level = std::clamp(range, BILATERAL_MIN_RANGE, BILATERAL_MAX_RANGE) * (max / 255.0f);
+  const float toCell = 1.0f / cell;
+  const float toLevel = 1.0f / level;
+  const bool alpha = channels == 2 || channels == 4;
+  const int colors = alpha ? channels - 1 : channels;
+  const size_t rowSamples = static_cast<size_t>(width) * channels;
+
+  // Every cell holds the sums of the colors and the number of pixels, padded on every side
+  const int values = colors + 1;
+  const int cellsX = static_cast<int>((width - 1) / cell) + 2 + 2 * GRID_PADDING;
+  const int cellsZ = static_cast<int>(max / level) + 2 + 2 * GRID_PADDING;
+  const size_t lineValues = static_cast<size_t>(cellsZ) * values;
+  const size_t rowValues = cellsX * lineValues;
+
+  // Every column splats to its nearest grid column and slices between the two around it
+  std::vector<int> nearestX(width);
+  std::vector<int> cornerX(width);
+  std::vector<float> weightX(width);
+  for (int x = 0; x < width; ++x) {
+    const float fx = x * toCell + GRID_PADDING;
+    nearestX[x] = static_cast<int>(fx + 0.5f);
+    cornerX[x] = static_cast<int>(fx);
+    weightX[x] = fx - cornerX[x];
+  }
+
+  // Split the grid rows that pixels are sliced from into strips, one per job
+  const int threads = getThreadCount();
+  const int sliceRows = static_cast<int>((height - 1) / cell) + 1;
+  const int strip = std::clamp((sliceRows + threads - 1) / threads, BILATERAL_MIN_STRIP, BILATERAL_MAX_STRIP);
+  const size_t jobs = (sliceRows + strip - 1) / strip;
+
+  // Every running job holds two grids of its strip, tens of MB each at the smallest sigmas
+  const size_t jobBytes = 2 * (strip + 2 * GRID_PADDING + 3) * rowValues * sizeof(float);
+  int workers = static_cast<int>(std::min<size_t>(threads, jobs));
+  while (workers > 1 && !MemoryTracker::get().fits(workers * jobBytes)) --workers;
+  runJobs(jobs, workers, [&](size_t job) {
+    const int first = static_cast<int>(job) * strip;
+    const int yBegin = job == 0 ? 0 : std::min(height, static_cast<int>(std::ceil(first * cell)));
+    const int yEnd = job + 1 == jobs ? height : std::min(height, static_cast<int>(std::ceil((first + strip) * cell)));
+    if (yBegin >= yEnd) return;
+
+    // The local grid starts far enough above the strip for the blur and the interpolation below it
+    const int base = first - GRID_PADDING - 1;
+    const int rows = strip + 2 * GRID_PADDING + 3;
+    FloatBuffer grid(rows * rowValues, 0.0f);
+    FloatBuffer blurred(rows * rowValues, 0.0f);
+
+    // Splat
+    const int splatBegin = std::max(0, static_cast<int>(std::floor((base - 0.5f) * cell)));
+    const int splatEnd = std::min(height, static_cast<int>(std::ceil((base + rows - 0.5f) * cell)));
+    for (int y = splatBegin; y < splatEnd; ++y) {
+      const int gy = static_cast<int>(y * toCell + 0.5f) - base;
+      if (gy < 0 || gy >= rows) continue;
+      const T* row = src + y * rowSamples;
+      float* gridRow = grid.data() + gy * rowValues;
+      for (int x = 0; x < width; ++x) {
+        const T* pixel = row + x * channels;
+        const int gz = static_cast<int>(grayOf(pixel, colors) * toLevel + 0.5f) + GRID_PADDING;
+        float* target = gridRow + nearestX[x] * lineValues + gz * values;
+        for (int c = 0; c < colors; ++c) target[c] += pixel[c];
+        target[colors] += 1.0f;
+      }
+    }
+
+    // Blur along the gray levels, the columns and the rows, skipping the padding
+    const size_t interiorZ = (cellsZ - 2 * GRID_PADDING) * static_cast<size_t>(values);
+    const size_t interiorX = (cellsX - 2 * GRID_PADDING) * lineValues;
+    for (int gy = 0; gy < rows; ++gy) {
+      for (int gx = GRID_PADDING; gx < cellsX - GRID_PADDING; ++gx) {
+        const size_t line = gy * rowValues + gx * lineValues + GRID_PADDING * values;
+        blurRun(grid.data() + line, blurred.data() + line, interiorZ, values);
+      }
+    }
+    for (int gy = 0; gy < rows; ++gy) {
+      const size_t row = gy * rowValues + GRID_PADDING * lineValues;
+      blurRun(blurred.data() + row, grid.data() + row, interiorX, lineValues);
+    }
+    for (int gy = GRID_PADDING; gy < rows - GRID_PADDING; ++gy) {
+      blurRun(grid.data() + gy * rowValues, blurred.data() + gy * rowValues, rowValues, rowValues);
+    }
+
+    // Slice
+    for (int y = yBegin; y < yEnd; ++y) {
+      const float fy = y * toCell - base;
+      const int iy = std::clamp(static_cast<int>(fy), GRID_PADDING, rows - GRID_PADDING - 2);
+      const float wy = std::clamp(fy - iy, 0.0f, 1.0f);
+      const T* in = src + y * rowSamples;
+      T* out = dst + y * rowSamples;
+      for (int x = 0; x < width; ++x) {
+        const T* pixel = in + x * channels;
+        const float fz = grayOf(pixel, colors) * toLevel + GRID_PADDING;
+        const int iz = static_cast<int>(fz);
+        const float wx = weightX[x];
+        const float wz = fz - iz;
+        const float* corner = blurred.data() + iy * rowValues + cornerX[x] * lineValues + iz * values;
+        float sums[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+        for (int k = 0; k < 8; ++k) {
+          const float weight = ((k & 4) ? wy : 1.0f - wy) * ((k & 2) ? wx : 1.0f - wx) * ((k & 1) ? wz : 1.0f - wz);
+          const float* cellValues = corner + ((k & 4) ? rowValues : 0) + ((k & 2) ? lineValues : 0) + ((k & 1) ? values : 0);
+          for (int v = 0; v < values; ++v) sums[v] += weight * cellValues[v];
+        }
+        for (int c = 0; c < colors; ++c) {
+          const float value = sums[colors] > 0.0f ? sums[c] / sums[colors] : pixel[c];
+          out[x * channels + c] = static_cast<T>(std::clamp(value, 0.0f, max) + 0.5f);
+        }
+        if (alpha) out[x * channels + colors] = pixel[colors]; // Alpha is kept as is
+      }
+    }
+  });
+}
+
+/////////////////// INSTANTIATIONS //////////////////////
+
+template void bilateralPixels<png_byte>(const png_byte*, png_byte*, int, int, int, float, float);
+template void bilateralPixels<png_uint_16>(const png_uint_16*, png_uint_16*, int, int, int, float, float);
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include "decode_cache.h"
+
+/////////////////// DECODE CACHE HELPERS ////////////////
+
+// @brief: Returns the memory held by a decoded image
+static size_t getImageBytes(const DecodedImage& image) {
+  return image.data.size() + image.palette.size() * sizeof(png_color) + image.trans.size();
+}
+
+/////////////////// DECODE CACHE CONSTRUCTOR ////////////
+
+// @brief: Initializes an empty cache
+DecodeCache::DecodeCache(void) {
+  this->cacheBytes = 0;
+  this->cacheBudget = DECODE_CACHE_BYTES;
+  this->clock = 0;
+}
+
+/////////////////// DECODE CACHE PRIVATE METHODS ////////
+
+// @brief: Drops the least recently used images until `needed` more bytes fit in the budget
+void DecodeCache::evict(size_t needed) {
+  while (!this->cache.empty() && this->cacheBytes + needed > this->cacheBudget) {
+    auto oldest = std::min_element(this->cache.begin(), this->cache.end(), [](const CacheEntry& a, const CacheEntry& b) { return a.lastUsed < b.lastUsed; });
+    this->cacheBytes -= getImageBytes(oldest->image);
+    this->cache.erase(oldest);
+  }
+}
+
+/////////////////// DECODE CACHE METHODS ////////////////
+
+// @brief: Returns the cache shared by the whole program
+DecodeCache& DecodeCache::get(void) {
+  static DecodeCache cache;
+  return cache;
+}
+
+// @brief: Copies a cached image
+// The pixels are copied into `image.data`, which keeps the memory category it was made with.
+// Images whose copy would not fit in the memory budget are left to be decoded, which makes room first.
+// @param `key`: The key of the file
+// @param `image`: Set to the cached image
+// @return: Whether the image was copied
+bool DecodeCache::lookup(const std::string& key, DecodedImage& image) {
+  if (key.empty()) return false;
+  std::lock_guard<std::mutex> guard(this->lock);
+  for (CacheEntry& entry : this->cache) {
+    if (entry.key != key) continue;
+    if (!MemoryTracker::get().fits(entry.image.data.size())) return false;
+    entry.lastUsed = ++this->clock;
+    image = entry.image;
+    return true;
+  }
+  return false;
+}
+
+// @brief: Caches a decoded image, evicting the least recently used images if needed
+// The image is moved in, so its pixels should already be in the CACHE category
+// @param `key`: The key of the file, taken before it was decoded
+// @param `image`: The decoded image
+void DecodeCache::store(const std::string& key, DecodedImage image) {
+  if (key.empty()) return;
+  const size_t bytes = getImageBytes(image);
+  if (bytes > this->cacheBudget) return;
+  std::lock_guard<std::mutex> guard(this->lock);
+  for (CacheEntry& entry : this->cache) {
+    if (entry.key == key) {
+      entry.lastUsed = ++this->clock;
+      return;
+    }
+  }
+  this->evict(bytes);
+  this->cache.push_back({ key, ++this->clock, std::move(image) });
+  this->cacheBytes += bytes;
+}
+
+// @brief: Drops the least recently used images until `bytes` more fit in the memory budget, or the cache is empty
+// @param `bytes`: The memory about to be allocated
+void DecodeCache::release(size_t bytes) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  while (!this->cache.empty() && !MemoryTracker::get().fits(bytes)) {
+    auto oldest = std::min_element(this->cache.begin(), this->cache.end(), [](const CacheEntry& a, const CacheEntry& b) { return a.lastUsed < b.lastUsed; });
+    this->cacheBytes -= getImageBytes(oldest->image);
+    this->cache.erase(oldest);
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+#include <png.h>
+#include "memory_tracker.h"
+
+/* Constants */
+const size_t DECODE_CACHE_BYTES = 512 << 20; // Default memory budget of the cached decoded files
+
+/* Decoded Image */
+// A PNG file as Image::load leaves it, before any edit
+struct DecodedImage {
+  int width;
+  int height;
+  int bitDepth;
+  int colorType;
+  std::vector<png_color> palette;
+  std::vector<png_byte> trans;
+  PixelBuffer data;
+};
+
+// Recently decoded files, shared by every image of the program, so that reopening a file or running
+// another batch job on it copies its pixels instead of decoding it again. Entries are keyed by getFileKey,
+// so a file that changed is decoded anew.
+class DecodeCache {
+private:
+  /* Private Types */
+  struct CacheEntry {
+    std::string key;
+    uint64_t lastUsed;
+    DecodedImage image;
+  };
+
+  /* Private Variables */
+  std::vector<CacheEntry> cache;
+  size_t cacheBytes;
+  size_t cacheBudget;
+  uint64_t clock;
+  std::mutex lock; // Files are loaded on background threads
+
+  /* Private Methods */
+  void evict(size_t needed);
+
+public:
+  /* Constructor */
+  DecodeCache(void);
+
+  /* Methods */
+  static DecodeCache& get(void);
+  bool lookup(const std::string& key, DecodedImage& image);
+  void store(const std::string& key, DecodedImage image);
+  void release(size_t bytes);
+};
@@ -0,0 +1,370 @@
+#include <iostream>
+#include <memory>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+#include <cstdlib>
+#include "encoder.h"
+#include "trace.h"
+
+/////////////////// ENCODER HELPERS /////////////////////
+
+// @brief: Returns the number of samples per pixel of a PNG color type
+static int getChannels(int colorType) {
+  switch (colorType) {
+    case PNG_COLOR_TYPE_GRAY_ALPHA: return 2;
+    case PNG_COLOR_TYPE_RGB: return 3;
+    case PNG_COLOR_TYPE_RGBA: return 4;
+    default: return 1; // Gray and palette
+  }
+}
+
+// @brief: Predicts a byte with the Paeth predictor
+static inline int paeth(int a, int b, int c) {
+  int p = a + b - c;
+  int pa = std::abs(p - a);
+  int pb = std::abs(p - b);
+  int pc = std::abs(p - c);
+  if (pa <= pb && pa <= pc) return a;
+  if (pb <= pc) return b;
+  return c;
+}
+
+// @brief: Copies a row of 16-bit host-order samples in network byte order
+static void toNetworkOrder(const png_byte* row, png_byte* out, size_t rowBytes) {
+  const png_uint_16 probe = 1;
+  if (*reinterpret_cast<const png_byte*>(&probe) == 0) {
+    std::copy(row, row + rowBytes, out);
+    return;
+  }
+  for (size_t i = 0; i + 1 < rowBytes; i += 2) {
+    out[i] = row[i + 1];
+    out[i + 1] = row[i];
+  }
+}
+
+// @brief: Packs one sub-byte sample per byte into rows of 1, 2 or 4-bit samples, most significant bits first
+static void packSamples(const png_byte* data, png_byte* out, int width, int height, int bitDepth, size_t rowBytes) {
+  const int perByte = 8 / bitDepth;
+  const png_byte mask = static_cast<png_byte>((1 << bitDepth) - 1);
+  for (int y = 0; y < height; ++y, data += width, out += rowBytes) {
+    std::fill(out, out + rowBytes, 0);
+    for (int x = 0; x < width; ++x) {
+      const int shift = 8 - bitDepth * (x % perByte + 1);
+      out[x / perByte] |= static_cast<png_byte>((data[x] & mask) << shift);
+    }
+  }
+}
+
+// @brief: Stores a 32-bit value in network byte order
+static inline void putUint32(png_byte* out, uint32_t value) {
+  out[0] = static_cast<png_byte>(value >> 24);
+  out[1] = static_cast<png_byte>(value >> 16);
+  out[2] = static_cast<png_byte>(value >> 8);
+  out[3] = static_cast<png_byte>(value);
+}
+
+/////////////////// ENCODER CONSTRUCTOR ///////////////////
+
+// @brief: Initializes the encoder for an image of the given layout
+// @param `width`: The image width
+// @param `height`: The image height
+// @param `bitDepth`: The bit depth of each sample
+// @param `colorType`: The PNG color type
+Encoder::Encoder(int width, int height, int bitDepth, int colorType) {
+  this->width = width;
+  this->height = height;
+  this->bitDepth = bitDepth;
+  this->colorType = colorType;
+  this->channels = getChannels(colorType);
+  this->threads = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+  this->profile = SaveProfile::BALANCED;
+}
+
+/////////////////// ENCODER PRIVATE METHODS ///////////////
+
+// @brief: Returns the number of bytes in one unfiltered row
+size_t Encoder::getRowBytes(void) const {
+  return (static_cast<size_t>(this->width) * this->channels * this->bitDepth + 7) / 8;
+}
+
+// @brief: Returns the filter distance in bytes (at least one)
+int Encoder::getPixelBytes(void) const {
+  return std::max(1, this->channels * this->bitDepth / 8);
+}
+
+// @brief: Filters one row into a filter type byte followed by the filtered bytes
+// @param `data`: The unfiltered image data, with 16-bit samples in host byte order
+// @param `y`: The row to filter
+// @param `out`: The output, resized to row bytes + 1
+// @param `scratch`: Scratch space reused between calls
+void Encoder::filterRow(const png_byte* data, int y, std::vector<png_byte>& out, std::vector<png_byte>& scratch) const {
+  const size_t rowBytes = this->getRowBytes();
+  const size_t bpp = this->getPixelBytes();
+  int level, memLevel, strategy;
+  bool adaptive;
+  Encoder::getProfileParameters(this->profile, level, memLevel, strategy, adaptive);
+
+  // The row above the first row is all zeros
+  scratch.resize(rowBytes * 7);
+  if (out.size() != rowBytes + 1) out.resize(rowBytes + 1);
+  const png_byte* row = data + y * rowBytes;
+  const png_byte* prev = y > 0 ? row - rowBytes : nullptr;
+
+  // PNG stores 16-bit samples most significant byte first
+  if (this->bitDepth == 16) {
+    toNetworkOrder(row, &scratch[rowBytes * 5], rowBytes);
+    row = &scratch[rowBytes * 5];
+    if (prev) {
+      toNetworkOrder(prev, &scratch[rowBytes * 6], rowBytes);
+      prev = &scratch[rowBytes * 6];
+    }
+  }
+
+  // Sub
+  png_byte* sub = adaptive ? &scratch[rowBytes * 1] : &out[1];
+  for (size_t i = 0; i < bpp && i < rowBytes; ++i) sub[i] = row[i];
+  for (size_t i = bpp; i < rowBytes; ++i) sub[i] = row[i] - row[i - bpp];
+  if (!adaptive) { out[0] = PNG_FILTER_VALUE_SUB; return; }
+
+  // None, Up, Average, Paeth
+  png_byte* up = &scratch[rowBytes * 2];
+  png_byte* avg = &scratch[rowBytes * 3];
+  png_byte* pth = &scratch[rowBytes * 4];
+  if (prev) {
+    for (size_t i = 0; i < rowBytes; ++i) up[i] = row[i] - prev[i];
+    for (size_t i = 0; i < bpp && i < rowBytes; ++i) avg[i] = row[i] - (prev[i] >> 1);
+    for (size_t i = bpp; i < rowBytes; ++i) avg[i] = row[i] - ((row[i - bpp] + prev[i]) >> 1);
+    for (size_t i = 0; i < bpp && i < rowBytes; ++i) pth[i] = row[i] - prev[i];
+    for (size_t i = bpp; i < rowBytes; ++i) pth[i] = row[i] - paeth(row[i - bpp], prev[i], prev[i - bpp]);
+  } else {
+    for (size_t i = 0; i < rowBytes; ++i) up[i] = row[i];
+    for (size_t i = 0; i < bpp && i < rowBytes; ++i) avg[i] = row[i];
+    for (size_t i = bpp; i < rowBytes; ++i) avg[i] = row[i] - (row[i - bpp] >> 1);
+    for (size_t i = 0; i < rowBytes; ++i) pth[i] = sub[i];
+  }
+
+  // Pick the filter with the minimum sum of absolute differences (libpng heuristic)
+  const png_byte* candidates[5] = { row, sub, up, avg, pth };
+  int best = 0;
+  uint64_t bestSum = UINT64_MAX;
+  for (int f = 0; f < 5; ++f) {
+    uint64_t sum = 0;
+    for (size_t i = 0; i < rowBytes; ++i) sum += std::abs(static_cast<int>(static_cast<signed char>(candidates[f][i])));
+    if (sum < bestSum) { bestSum = sum; best = f; }
+  }
+  out[0] = static_cast<png_byte>(best);
+  std::copy(candidates[best], candidates[best] + rowBytes, out.begin() + 1);
+}
+
+// @brief: Filters and deflates a strip of rows into a raw deflate fragment
+// @param `data`: The unfiltered image data
+// @param `first`: The first row of the strip
+// @param `last`: One past the last row of the strip
+// @param `out`: The compressed fragment
+// @param `adler`: The Adler-32 checksum of the filtered strip
+bool Encoder::deflateStrip(const png_byte* data, int first, int last, PixelBuffer& out, uLong& adler) const {
+  int level, memLevel, strategy;
+  bool adaptive;
+  Encoder::getProfileParameters(this->profile, level, memLevel, strategy, adaptive);
+
+  z_stream stream = {};
+  if (deflateInit2(&stream, level, Z_DEFLATED, -15, memLevel, strategy) != Z_OK) {
+    std::cerr << "Failed to initialize deflate stream" << std::endl;
+    return false;
+  }
+  std::unique_ptr<z_stream, decltype(&deflateEnd)> guard(&stream, deflateEnd);
+
+  std::vector<png_byte> row;
+  std::vector<png_byte> scratch;
+  const size_t rowBytes = this->getRowBytes();
+
+  // Prime the window with the filtered tail of the previous strip
+  if (first > 0) {
+    int rows = std::min(first, static_cast<int>((ENCODER_WINDOW_BYTES + rowBytes) / (rowBytes + 1)));
+    std::vector<png_byte> dictionary;
+    for (int y = first - rows; y < first; ++y) {
+      this->filterRow(data, y, row, scratch);
+      dictionary.insert(dictionary.end(), row.begin(), row.end());
+    }
+    size_t size = std::min(dictionary.size(), ENCODER_WINDOW_BYTES);
+    deflateSetDictionary(&stream, &dictionary[dictionary.size() - size], static_cast<uInt>(size));
+  }
+
+  // Filter and compress each row
+  adler = adler32(0L, Z_NULL, 0);
+  out.resize(deflateBound(&stream, static_cast<uLong>((last - first) * (rowBytes + 1))) + 16);
+  stream.next_out = out.data();
+  stream.avail_out = static_cast<uInt>(out.size());
+  for (int y = first; y < last; ++y) {
+    this->filterRow(data, y, row, scratch);
+    adler = adler32(adler, row.data(), static_cast<uInt>(row.size()));
+
+    // Strips end on a byte boundary so that they can be concatenated
+    int flush = y + 1 < last ? Z_NO_FLUSH : (last == this->height ? Z_FINISH : Z_SYNC_FLUSH);
+    stream.next_in = row.data();
+    stream.avail_in = static_cast<uInt>(row.size());
+    do {
+      if (stream.avail_out == 0) {
+        size_t used = out.size();
+        out.resize(used * 2);
+        stream.next_out = out.data() + used;
+        stream.avail_out = static_cast<uInt>(out.size() - used);
+      }
+      int result = deflate(&stream, flush);
+      if (result == Z_STREAM_ERROR) {
+        std::cerr << "Failed to deflate PNG strip" << std::endl;
+        return false;
+      }
+    } while (stream.avail_in > 0 || stream.avail_out == 0);
+  }
+  out.resize(out.size() - stream.avail_out);
+
+  return true;
+}
+
+// @brief: Writes a PNG chunk with its length and CRC
+// @param `fp`: The file to write to
+// @param `type`: The four-letter chunk type
+// @param `data`: The chunk data
+// @param `length`: The chunk data length
+bool Encoder::writeChunk(FILE* fp, const char* type, const png_byte* data, size_t length) const {
+  png_byte header[8];
+  putUint32(header, static_cast<uint32_t>(length));
+  std::copy(type, type + 4, header + 4);
+  uLong crc = crc32(0L, header + 4, 4);
+  if (length) crc = crc32(crc, data, static_cast<uInt>(length));
+  png_byte footer[4];
+  putUint32(footer, static_cast<uint32_t>(crc));
+
+  if (fwrite(header, 1, 8, fp) != 8) return false;
+  if (length && fwrite(data, 1, length, fp) != length) return false;
+  return fwrite(footer, 1, 4, fp) == 4;
+}
+
+/////////////////// ENCODER METHODS ///////////////////////
+
+// @brief: Encodes the image on several threads and writes it to a file
+// @param `path`: The path to the output file
+// @param `data`: The unfiltered image data, one row after another, with 16-bit samples in host byte order
+//                and 1, 2 or 4-bit samples one per byte
+bool Encoder::write(const std::string path, const png_byte* data) {
+  int level, memLevel, strategy;
+  bool adaptive;
+  Encoder::getProfileParameters(this->profile, level, memLevel, strategy, adaptive);
+  if (this->width <= 0 || this->height <= 0) {
+    std::cerr << "Failed to encode empty image: " << path << std::endl;
+    return false;
+  }
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE && this->palette.empty()) {
+    std::cerr << "Failed to encode indexed image without a palette: " << path << std::endl;
+    return false;
+  }
+
+  // Pack sub-byte samples into whole rows
+  const size_t rowBytes = this->getRowBytes();
+  PixelBuffer packed;
+  if (this->bitDepth < 8) {
+    packed.resize(rowBytes * this->height);
+    packSamples(data, packed.data(), this->width, this->height, this->bitDepth, rowBytes);
+    data = packed.data();
+  }
+
+  // Split the image into strips of whole rows
+  const int rowsPerStrip = static_cast<int>(std::max<size_t>(1, ENCODER_STRIP_BYTES / (rowBytes + 1)));
+  const int strips = (this->height + rowsPerStrip - 1) / rowsPerStrip;
+  std::vector<PixelBuffer> fragments(strips);
+  std::vector<uLong> adlers(strips);
+
+  // Filter and deflate the strips in parallel
+  std::atomic<int> next(0);
+  std::atomic<bool> failed(false);
+  auto worker = [&]() {
+    for (int s = next++; s < strips && !failed; s = next++) {
+      TraceScope scope("Deflate strip");
+      int first = s * rowsPerStrip;
+      int last = std::min(this->height, first + rowsPerStrip);
+      if (!this->deflateStrip(data, first, last, fragments[s], adlers[s])) failed = true;
+    }
+  };
+  std::vector<std::thread> pool;
+  for (int t = 1; t < std::min(this->threads, strips); ++t) pool.emplace_back(worker);
+  worker();
+  for (std::thread& thread : pool) thread.join();
+  if (failed) return false;
+
+  // Combine the checksums of the strips
+  uLong adler = adler32(0L, Z_NULL, 0);
+  for (int s = 0; s < strips; ++s) {
+    int rows = std::min(this->height - s * rowsPerStrip, rowsPerStrip);
+    adler = adler32_combine(adler, adlers[s], static_cast<z_off_t>(rows * (rowBytes + 1)));
+  }
+
+  // Open the file
+  FILE* fp = fopen(path.c_str(), "wb");
+  if (!fp) {
+    std::cerr << "Failed to open for writing: " << path << std::endl;
+    return false;
+  }
+  std::unique_ptr<FILE, decltype(&fclose)> file(fp, fclose);
+
+  // Write the signature and header
+  static const png_byte signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+  png_byte ihdr[13];
+  putUint32(ihdr + 0, static_cast<uint32_t>(this->width));
+  putUint32(ihdr + 4, static_cast<uint32_t>(this->height));
+  ihdr[8] = static_cast<png_byte>(this->bitDepth);
+  ihdr[9] = static_cast<png_byte>(this->colorType);
+  ihdr[10] = PNG_COMPRESSION_TYPE_BASE;
+  ihdr[11] = PNG_FILTER_TYPE_BASE;
+  ihdr[12] = PNG_INTERLACE_NONE;
+  bool ok = fwrite(signature, 1, 8, fp) == 8 && this->writeChunk(fp, "IHDR", ihdr, sizeof(ihdr));
+
+  // Write the palette, and its alpha values up to the last transparent entry
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE) {
+    ok = ok && this->writeChunk(fp, "PLTE", reinterpret_cast<const png_byte*>(this->palette.data()), this->palette.size() * 3);
+    size_t count = this->trans.size();
+    while (count > 0 && this->trans[count - 1] == 255) --count;
+    if (count > 0) ok = ok && this->writeChunk(fp, "tRNS", this->trans.data(), count);
+  }
+
+  // Write the zlib header, one IDAT per strip, and the combined checksum
+  png_byte zlibHeader[2] = { 0x78, static_cast<png_byte>((level < 2 ? 0 : level < 6 ? 1 : level == 6 ? 2 : 3) << 6) };
+  zlibHeader[1] += 31 - (zlibHeader[0] * 256 + zlibHeader[1]) % 31;
+  png_byte zlibTrailer[4];
+  putUint32(zlibTrailer, static_cast<uint32_t>(adler));
+  fragments.front().insert(fragments.front().begin(), zlibHeader, zlibHeader + 2);
+  fragments.back().insert(fragments.back().end(), zlibTrailer, zlibTrailer + 4);
+  for (int s = 0; s < strips && ok; ++s) ok = this->writeChunk(fp, "IDAT", fragments[s].data(), fragments[s].size());
+  ok = ok && this->writeChunk(fp, "IEND", nullptr, 0);
+
+  if (!ok) {
+    std::cerr << "Failed to write PNG data: " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+// @brief: Returns the zlib parameters of a save profile
+// @param `profile`: The save profile
+// @param `level`: The zlib compression level
+// @param `memLevel`: The zlib memory level
+// @param `strategy`: The zlib compression strategy
+// @param `adaptive`: Whether every row picks its own filter
+void Encoder::getProfileParameters(SaveProfile profile, int& level, int& memLevel, int& strategy, bool& adaptive) {
+  switch (profile) {
+    case SaveProfile::FASTEST:  level = 1; memLevel = 8; strategy = Z_RLE;      adaptive = false; break;
+    case SaveProfile::SMALLEST: level = 9; memLevel = 9; strategy = Z_FILTERED; adaptive = true;  break;
+    case SaveProfile::BALANCED:
+    default:                    level = 6; memLevel = 8; strategy = Z_FILTERED; adaptive = true;  break;
+  }
+}
+
+/////////////////// ENCODER SETTERS ///////////////////////
+
+void Encoder::setProfile(SaveProfile profile) { this->profile = profile; }
+void Encoder::setThreads(int threads) { this->threads = std::max(1, threads); }
+void Encoder::setPalette(const std::vector<png_color>& palette, const std::vector<png_byte>& trans) {
+  this->palette = palette;
+  this->trans = trans;
+}
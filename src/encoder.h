@@ -0,0 +1,45 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <png.h>
+#include <zlib.h>
+#include "image.h"
+
+/* Constants */
+const size_t ENCODER_STRIP_BYTES = 1 << 20; // Uncompressed bytes per strip
+const size_t ENCODER_WINDOW_BYTES = 32768;  // Deflate window size
+
+class Encoder {
+private:
+  /* Private Variables */
+  int width;
+  int height;
+  int bitDepth;
+  int colorType;
+  int channels;
+  int threads;
+  SaveProfile profile;
+  std::vector<png_color> palette;
+  std::vector<png_byte> trans;
+
+  /* Private Methods */
+  size_t getRowBytes(void) const;
+  int getPixelBytes(void) const;
+  void filterRow(const png_byte* data, int y, std::vector<png_byte>& out, std::vector<png_byte>& scratch) const;
+  bool deflateStrip(const png_byte* data, int first, int last, PixelBuffer& out, uLong& adler) const;
+  bool writeChunk(FILE* fp, const char* type, const png_byte* data, size_t length) const;
+
+public:
+  /* Constructor */
+  Encoder(int width, int height, int bitDepth, int colorType);
+
+  /* Methods */
+  bool write(const std::string path, const png_byte* data);
+  static void getProfileParameters(SaveProfile profile, int& level, int& memLevel, int& strategy, bool& adaptive);
+
+  /* Setters */
+  void setProfile(SaveProfile profile);
+  void setThreads(int threads);
+  void setPalette(const std::vector<png_color>& palette, const std::vector<png_byte>& trans);
+};
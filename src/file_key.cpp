@@ -0,0 +1,19 @@
+#include <filesystem>
+#include <cstdint>
+#include "file_key.h"
+
+/////////////////// FILE KEYS ///////////////////////////
+
+// @brief: Returns the key of a file as it is now
+// @param `path`: The path to the file
+// @return: The canonical path, modification time and size of the file, or an empty key if it cannot be examined
+std::string getFileKey(const std::string& path) {
+  std::error_code error;
+  const std::string canonical = std::filesystem::canonical(path, error).string();
+  if (error) return "";
+  const auto modified = std::filesystem::last_write_time(path, error).time_since_epoch().count();
+  if (error) return "";
+  const uintmax_t size = std::filesystem::file_size(path, error);
+  if (error) return "";
+  return canonical + '\n' + std::to_string(modified) + '\n' + std::to_string(size);
+}
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <string>
+
+/* File Keys */
+// Identifies a file as it is now by its canonical path, modification time and size, so that caches
+// of anything derived from the file miss once it changes. Returns an empty key if the file cannot be examined.
+std::string getFileKey(const std::string& path);
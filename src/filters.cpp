@@ -0,0 +1,281 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include "filters.h"
+
+// The public filters switch on the channel count once and call a loop specialized
+// for that layout, so the stride is a compile-time constant and the loops vectorize.
+#define DISPATCH_CHANNELS(channels, call) \
+  switch (channels) { \
+    case 1: { constexpr int C = 1; call; break; } \
+    case 2: { constexpr int C = 2; call; break; } \
+    case 3: { constexpr int C = 3; call; break; } \
+    default: { constexpr int C = 4; call; break; } \
+  }
+
+// @brief: Returns whether a layout of `C` channels ends with an alpha channel
+template <int C> constexpr bool hasAlpha(void) { return C == 2 || C == 4; }
+
+// @brief: Returns the number of color channels in a layout of `C` channels
+template <int C> constexpr int colorChannels(void) { return hasAlpha<C>() ? C - 1 : C; }
+
+/////////////////// KERNEL SCALE ////////////////////////
+
+const size_t KERNEL_CHUNK = 256; // Samples summed at a time, in a buffer that stays in registers or L1
+
+// Divides kernel sums by the kernel divisor with one multiply and shift, rounding to nearest.
+// The rounded sum is saturated first, which bounds it to [0, (max + 1) * divisor) and lets the
+// division by a constant use a multiplier m = ceil(2^s / divisor) that is exact over that range.
+struct KernelScale {
+  int half;
+  int limit;
+  uint32_t multiplier;
+  int shift;
+  float inverse; // Float samples are scaled directly
+
+  KernelScale(int divisor, int max) {
+    this->half = divisor / 2;
+    this->limit = (max + 1) * divisor - 1;
+    int bits = 0;
+    while ((1 << bits) <= this->limit) ++bits;
+    int divisorBits = 0;
+    while ((1 << divisorBits) < divisor) ++divisorBits;
+    this->shift = bits + divisorBits;
+    this->multiplier = static_cast<uint32_t>(((uint64_t(1) << this->shift) + divisor - 1) / divisor);
+    this->inverse = 1.0f / divisor;
+  }
+
+  // @brief: Returns the rounded and saturated quotient of a kernel sum
+  template <typename T, typename Acc>
+  T apply(Acc sum) const {
+    if constexpr (std::is_floating_point_v<T>) {
+      return static_cast<T>(std::clamp(sum * this->inverse, 0.0f, SampleTraits<T>::max));
+    } else {
+      // 8-bit products stay below 2^32 for divisors up to 128, so they get 32-bit lanes
+      using Wide = std::conditional_t<sizeof(T) == 1, uint32_t, uint64_t>;
+      const uint32_t value = static_cast<uint32_t>(std::clamp(static_cast<int32_t>(sum) + this->half, 0, this->limit));
+      return static_cast<T>((static_cast<Wide>(value) * this->multiplier) >> this->shift);
+    }
+  }
+};
+
+/////////////////// LAYOUT KERNELS //////////////////////
+
+template <typename T, int C>
+static void invertPixels(T* row, int width) {
+  const T max = static_cast<T>(SampleTraits<T>::max);
+  const size_t count = C * static_cast<size_t>(width);
+  for (size_t i = 0; i < count; ++i) {
+    T value = row[i];
+    row[i] = hasAlpha<C>() && i % C == C - 1 ? value : static_cast<T>(max - value); // Alpha is kept as is
+  }
+}
+
+template <typename T, int C>
+static void grayscalePixels(T* row, int width) {
+  using Sum = typename SampleTraits<T>::Sum;
+  if (colorChannels<C>() == 1) return; // Already gray
+  for (int x = 0; x < width; ++x) {
+    T* pixel = row + C * static_cast<size_t>(x);
+    T avg = static_cast<T>((static_cast<Sum>(pixel[0]) + pixel[1] + pixel[2]) / 3);
+    pixel[0] = avg; // R
+    pixel[1] = avg; // G
+    pixel[2] = avg; // B
+  }
+}
+
+template <typename T, int C>
+static void rgbPixels(T* row, int width, float red, float green, float blue) {
+  // Gray layouts use the red gain; Image expands them to RGB when the gains differ
+  const float gains[4] = { red, green, blue, 1.0f };
+  float gain[C];
+  for (int c = 0; c < C; ++c) gain[c] = c < colorChannels<C>() ? gains[c] : 1.0f; // Alpha is kept as is
+  const size_t count = C * static_cast<size_t>(width);
+  for (size_t i = 0; i < count; ++i) {
+    row[i] = static_cast<T>(std::min(row[i] * gain[i % C], SampleTraits<T>::max));
+  }
+}
+
+template <typename T, typename Acc, int C>
+static void kernelPixels(const T* above, const T* row, const T* below, T* out, int width, const FilterKernel& kernel, KernelScale scale) {
+  const T* rows[3] = { above, row, below };
+  std::copy(row, row + C * static_cast<size_t>(width), out);
+  if (width < 3) return;
+
+  // Each tap is a multiply-add over a contiguous run of samples, so the loops map onto
+  // pmaddwd-style instructions; pixels with alpha are filtered whole and the alpha restored after
+  const size_t inner = C * static_cast<size_t>(width - 2);
+  Acc sums[KERNEL_CHUNK];
+  for (size_t start = 0; start < inner; start += KERNEL_CHUNK) {
+    const size_t count = std::min(KERNEL_CHUNK, inner - start);
+    std::fill(sums, sums + count, Acc(0));
+    for (int ky = 0; ky < 3; ++ky) {
+      for (int kx = 0; kx < 3; ++kx) {
+        const Acc tap = static_cast<Acc>(kernel.taps[ky][kx]);
+        if (tap == 0) continue;
+        const T* src = rows[ky] + start + C * kx;
+        if (tap == 1) for (size_t i = 0; i < count; ++i) sums[i] += static_cast<Acc>(src[i]);
+        else if (tap == -1) for (size_t i = 0; i < count; ++i) sums[i] -= static_cast<Acc>(src[i]);
+        else for (size_t i = 0; i < count; ++i) sums[i] += static_cast<Acc>(tap * src[i]);
+      }
+    }
+    T* dst = out + C + start;
+    for (size_t i = 0; i < count; ++i) dst[i] = scale.apply<T>(sums[i]);
+  }
+  if (!hasAlpha<C>()) return;
+  for (size_t i = 2 * C - 1; i < inner + C; i += C) out[i] = row[i]; // Alpha is kept as is
+}
+
+template <typename T, int C>
+static void rotateLayout(const T* src, T* dst, int width, int height, int angle) {
+  // [[cos(theta), -sin(theta)], [sin(theta), cos(theta)]] * [x, y]
+  const float rad = angle * M_PI / 180.0f;
+  const float sinRad = std::sin(rad);
+  const float cosRad = std::cos(rad);
+  std::fill(dst, dst + C * static_cast<size_t>(width) * height, T(0));
+
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      int ny = static_cast<int>(std::round((x - width / 2.0f) * sinRad + (y - height / 2.0f) * cosRad + height / 2.0f));
+      int nx = static_cast<int>(std::round((x - width / 2.0f) * cosRad - (y - height / 2.0f) * sinRad + width / 2.0f));
+      if (ny < 0 || ny >= height || nx < 0 || nx >= width) continue;
+
+      const T* from = src + C * (static_cast<size_t>(ny) * width + nx);
+      std::copy(from, from + C, dst + C * (static_cast<size_t>(y) * width + x));
+    }
+  }
+}
+
+/////////////////// ROW FILTERS /////////////////////////
+
+// @brief: Inverts the colors of a row
+// @param `row`: The row
+// @param `width`: The number of pixels in the row
+// @param `channels`: The number of channels per pixel
+template <typename T>
+void invertRow(T* row, int width, int channels) {
+  DISPATCH_CHANNELS(channels, (invertPixels<T, C>(row, width)))
+}
+
+// @brief: Grayscales a row; gray layouts are left as they are
+// @param `row`: The row
+// @param `width`: The number of pixels in the row
+// @param `channels`: The number of channels per pixel
+template <typename T>
+void grayscaleRow(T* row, int width, int channels) {
+  DISPATCH_CHANNELS(channels, (grayscalePixels<T, C>(row, width)))
+}
+
+// @brief: Scales the color values of a row
+// @param `row`: The row
+// @param `width`: The number of pixels in the row
+// @param `channels`: The number of channels per pixel
+// @param `red`, `green`, `blue`: The gain of each channel
+template <typename T>
+void rgbRow(T* row, int width, int channels, float red, float green, float blue) {
+  DISPATCH_CHANNELS(channels, (rgbPixels<T, C>(row, width, red, green, blue)))
+}
+
+// @brief: Applies a 3x3 kernel to a row given its neighbors
+// Integer samples are summed in fixed point and divided once, so the result is bit-exact on every
+// compiler. 8-bit rows use 16-bit sums whenever the kernel cannot overflow them.
+// The first and last pixels have no left/right neighbor and are copied as is
+// @param `above`, `row`, `below`: The source rows
+// @param `out`: The destination row (must not alias the source rows)
+// @param `width`: The number of pixels in the row
+// @param `channels`: The number of channels per pixel
+// @param `kernel`: The kernel to apply
+template <typename T>
+void kernelRow(const T* above, const T* row, const T* below, T* out, int width, int channels, const FilterKernel& kernel) {
+  const KernelScale scale(kernel.divisor, static_cast<int>(SampleTraits<T>::max));
+  if constexpr (std::is_floating_point_v<T>) {
+    DISPATCH_CHANNELS(channels, (kernelPixels<T, float, C>(above, row, below, out, width, kernel, scale)))
+  } else {
+    int weight = 0;
+    for (int ky = 0; ky < 3; ++ky) {
+      for (int kx = 0; kx < 3; ++kx) weight += std::abs(kernel.taps[ky][kx]);
+    }
+    if (sizeof(T) == 1 && weight * static_cast<int>(SampleTraits<T>::max) <= INT16_MAX) {
+      DISPATCH_CHANNELS(channels, (kernelPixels<T, int16_t, C>(above, row, below, out, width, kernel, scale)))
+    } else {
+      DISPATCH_CHANNELS(channels, (kernelPixels<T, int32_t, C>(above, row, below, out, width, kernel, scale)))
+    }
+  }
+}
+
+/////////////////// IMAGE FILTERS ///////////////////////
+
+// @brief: Rotates an image around its center, clearing uncovered pixels to zero
+// @param `src`: The source pixels
+// @param `dst`: The destination pixels (must not alias `src`)
+// @param `width`, `height`: The image size
+// @param `channels`: The number of channels per pixel
+// @param `angle`: The rotation in degrees
+template <typename T>
+void rotatePixels(const T* src, T* dst, int width, int height, int channels, int angle) {
+  DISPATCH_CHANNELS(channels, (rotateLayout<T, C>(src, dst, width, height, angle)))
+}
+
+// @brief: Converts pixels between layouts, replicating gray into RGB and adding opaque alpha
+// Converting color to gray is not supported
+// @param `src`: The source pixels
+// @param `srcChannels`: The number of channels per source pixel
+// @param `dst`: The destination pixels (must not alias `src`)
+// @param `dstChannels`: The number of channels per destination pixel
+// @param `count`: The number of pixels
+template <typename T>
+void convertPixels(const T* src, int srcChannels, T* dst, int dstChannels, size_t count) {
+  const bool srcAlpha = srcChannels == 2 || srcChannels == 4;
+  const bool dstAlpha = dstChannels == 2 || dstChannels == 4;
+  const int srcColors = srcAlpha ? srcChannels - 1 : srcChannels;
+  const int dstColors = dstAlpha ? dstChannels - 1 : dstChannels;
+  const T opaque = static_cast<T>(SampleTraits<T>::max);
+  for (size_t i = 0; i < count; ++i, src += srcChannels, dst += dstChannels) {
+    for (int c = 0; c < dstColors; ++c) dst[c] = src[srcColors == 1 ? 0 : c];
+    if (dstAlpha) dst[dstColors] = srcAlpha ? src[srcColors] : opaque;
+  }
+}
+
+/////////////////// PALETTE FILTERS /////////////////////
+
+static_assert(sizeof(png_color) == 3, "PLTE entries are edited as packed RGB pixels");
+
+void invertPalette(png_color* palette, int count) {
+  invertRow(reinterpret_cast<png_byte*>(palette), count, 3);
+}
+
+void grayscalePalette(png_color* palette, int count) {
+  grayscaleRow(reinterpret_cast<png_byte*>(palette), count, 3);
+}
+
+void rgbPalette(png_color* palette, int count, float red, float green, float blue) {
+  rgbRow(reinterpret_cast<png_byte*>(palette), count, 3, red, green, blue);
+}
+
+// @brief: Looks up palette indices as RGB or RGBA pixels
+// Indices past the end of the palette are black, and entries without a tRNS value are opaque.
+void expandIndices(const png_byte* indices, png_byte* dst, int dstChannels, size_t count, const png_color* palette, int paletteSize, const png_byte* trans, int transSize) {
+  for (size_t i = 0; i < count; ++i, dst += dstChannels) {
+    const int index = indices[i];
+    const png_color color = index < paletteSize ? palette[index] : png_color{ 0, 0, 0 };
+    dst[0] = color.red;
+    dst[1] = color.green;
+    dst[2] = color.blue;
+    if (dstChannels == 4) dst[3] = index < transSize ? trans[index] : 255;
+  }
+}
+
+/////////////////// INSTANTIATIONS //////////////////////
+
+#define INSTANTIATE_FILTERS(T) \
+  template void invertRow<T>(T*, int, int); \
+  template void grayscaleRow<T>(T*, int, int); \
+  template void rgbRow<T>(T*, int, int, float, float, float); \
+  template void kernelRow<T>(const T*, const T*, const T*, T*, int, int, const FilterKernel&); \
+  template void rotatePixels<T>(const T*, T*, int, int, int, int); \
+  template void convertPixels<T>(const T*, int, T*, int, size_t);
+
+INSTANTIATE_FILTERS(png_byte)
+INSTANTIATE_FILTERS(png_uint_16)
+INSTANTIATE_FILTERS(float)
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <png.h>
+
+/* Sample Traits */
+// Describes the range of one channel sample and the type used to sum samples
+template <typename T> struct SampleTraits;
+template <> struct SampleTraits<png_byte> { using Sum = unsigned int; static constexpr float max = 255.0f; };
+template <> struct SampleTraits<png_uint_16> { using Sum = unsigned int; static constexpr float max = 65535.0f; };
+template <> struct SampleTraits<float> { using Sum = float; static constexpr float max = 1.0f; };
+
+/* Filter Kernel */
+// A 3x3 kernel of small integer taps. The weighted sum of the neighborhood is divided by
+// `divisor` (1 to 128) once, rounding to nearest, and saturated to the sample range.
+struct FilterKernel {
+  int taps[3][3];
+  int divisor;
+};
+
+const FilterKernel BLUR_KERNEL = { { { 1, 1, 1 }, { 1, 1, 1 }, { 1, 1, 1 } }, 9 };
+const FilterKernel SHARPEN_KERNEL = { { { -1, -1, -1 }, { -1, 17, -1 }, { -1, -1, -1 } }, 9 };
+
+/* Row Filters */
+// Each filter works on `width` pixels of 1 (G), 2 (GA), 3 (RGB) or 4 (RGBA) channels and
+// leaves the alpha channel untouched. Every layout gets its own specialized loop.
+// They are instantiated for png_byte (8-bit), png_uint_16 (16-bit) and float samples.
+template <typename T> void invertRow(T* row, int width, int channels);
+template <typename T> void grayscaleRow(T* row, int width, int channels);
+template <typename T> void rgbRow(T* row, int width, int channels, float red, float green, float blue);
+template <typename T> void kernelRow(const T* above, const T* row, const T* below, T* out, int width, int channels, const FilterKernel& kernel);
+
+/* Image Filters */
+template <typename T> void rotatePixels(const T* src, T* dst, int width, int height, int channels, int angle);
+template <typename T> void convertPixels(const T* src, int srcChannels, T* dst, int dstChannels, size_t count);
+
+/* Palette Filters */
+// Point operations on indexed images only rewrite the PLTE entries, which are edited as RGB pixels.
+// The tRNS alpha values are kept apart and left untouched.
+void invertPalette(png_color* palette, int count);
+void grayscalePalette(png_color* palette, int count);
+void rgbPalette(png_color* palette, int count, float red, float green, float blue);
+void expandIndices(const png_byte* indices, png_byte* dst, int dstChannels, size_t count, const png_color* palette, int paletteSize, const png_byte* trans, int transSize);
@@ -0,0 +1,202 @@
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include <type_traits>
+#include "gaussian.h"
+#include "filters.h"
+#include "parallel.h"
+#include "memory_tracker.h"
+
+/////////////////// GAUSSIAN HELPERS ////////////////////
+
+using LineBuffer = std::vector<double, TrackedAllocator<double>>;
+
+// @brief: Rounds and clamps a filtered value to the sample range
+template <typename T>
+static T toSample(double value) {
+  const double clamped = std::clamp(value, 0.0, static_cast<double>(SampleTraits<T>::max));
+  if constexpr (std::is_floating_point_v<T>) return static_cast<T>(clamped);
+  else return static_cast<T>(clamped + 0.5);
+}
+
+// @brief: Runs the recursive filter forward and backward along `lanes` independent lines in place
+// The lines are stored side by side, so every step is one multiply-add over a contiguous run of
+// lanes, which vectorizes; the cost does not depend on sigma. The poles sit close to 1 at large
+// sigma, which amplifies rounding errors in the feedback, so the lines are kept in double.
+// @param `data`: `length` rows of `lanes` samples
+// @param `length`: The number of samples along each line
+// @param `lanes`: The number of lines
+// @param `g`: The filter coefficients
+static void recurseLines(double* data, int length, size_t lanes, const GaussianCoefficients& g) {
+  std::vector<double> edges(5 * lanes);
+  double* first = edges.data();
+  double* last = first + lanes;
+  double* future[3] = { first + 2 * lanes, first + 3 * lanes, first + 4 * lanes };
+  std::copy(data, data + lanes, first);
+  std::copy(data + (length - 1) * lanes, data + length * lanes, last);
+
+  // Causal pass, starting from the steady state of a line extended with its first sample
+  const double* p1 = first;
+  const double* p2 = first;
+  const double* p3 = first;
+  for (int n = 0; n < length; ++n) {
+    double* row = data + n * lanes;
+    for (size_t i = 0; i < lanes; ++i) row[i] = g.gain * row[i] + g.a1 * p1[i] + g.a2 * p2[i] + g.a3 * p3[i];
+    p3 = p2;
+    p2 = p1;
+    p1 = row;
+  }
+
+  // Anti-causal pass, starting from the outputs that a line extended with its last sample would
+  // have at the last sample and the two past it
+  double* end = data + (length - 1) * lanes;
+  const double* w1 = data + std::max(length - 2, 0) * lanes;
+  const double* w2 = data + std::max(length - 3, 0) * lanes;
+  for (size_t i = 0; i < lanes; ++i) {
+    const double u[3] = { end[i] - last[i], w1[i] - last[i], w2[i] - last[i] };
+    for (int k = 0; k < 3; ++k) future[k][i] = g.boundary[k][0] * u[0] + g.boundary[k][1] * u[1] + g.boundary[k][2] * u[2] + last[i];
+  }
+  std::copy(future[0], future[0] + lanes, end);
+  const double* n1 = end;
+  const double* n2 = future[1];
+  const double* n3 = future[2];
+  for (int n = length - 2; n >= 0; --n) {
+    double* row = data + n * lanes;
+    for (size_t i = 0; i < lanes; ++i) row[i] = g.gain * row[i] + g.a1 * n1[i] + g.a2 * n2[i] + g.a3 * n3[i];
+    n3 = n2;
+    n2 = n1;
+    n1 = row;
+  }
+}
+
+/////////////////// GAUSSIAN COEFFICIENTS ///////////////
+
+// @brief: Fits the recursive filter to a Gaussian
+// @param `sigma`: The standard deviation in pixels, clamped to [GAUSSIAN_MIN_SIGMA, GAUSSIAN_MAX_SIGMA]
+GaussianCoefficients::GaussianCoefficients(float sigma) {
+  const double s = std::clamp(sigma, GAUSSIAN_MIN_SIGMA, GAUSSIAN_MAX_SIGMA);
+  const double q = s >= 2.5 ? 0.98711 * s - 0.96330 : 3.97156 - 4.14554 * std::sqrt(1.0 - 0.26891 * s);
+  const double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+  const double a1 = (2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q) / b0;
+  const double a2 = -(1.4281 * q * q + 1.26661 * q * q * q) / b0;
+  const double a3 = (0.422205 * q * q * q) / b0;
+  this->gain = 1.0 - (a1 + a2 + a3);
+  this->a1 = a1;
+  this->a2 = a2;
+  this->a3 = a3;
+
+  const double m[3][3] = {
+    { -a3 * a1 + 1.0 - a3 * a3 - a2, (a3 + a1) * (a2 + a3 * a1), a3 * (a1 + a3 * a2) },
+    { a1 + a3 * a2, -(a2 - 1.0) * (a2 + a3 * a1), -(a3 * a1 + a3 * a3 + a2 - 1.0) * a3 },
+    { a3 * a1 + a2 + a1 * a1 - a2 * a2, a1 * a2 + a3 * a2 * a2 - a1 * a3 * a3 - a3 * a3 * a3 - a3 * a2 + a3, a3 * (a1 + a3 * a2) }
+  };
+  const double scale = (1.0 - (a1 + a2 + a3)) / ((1.0 + a1 - a2 + a3) * (1.0 - a1 - a2 - a3) * (1.0 + a2 + (a1 - a3) * a3));
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 3; ++j) this->boundary[i][j] = m[i][j] * scale;
+  }
+}
+
+/////////////////// GAUSSIAN PASSES /////////////////////
+
+// @brief: Blurs an image with a recursive Gaussian and combines every blurred sample with its source
+// The vertical pass filters strips of columns down the image; the horizontal pass transposes
+// blocks of rows so that it runs down columns as well. Both passes split the work across threads.
+// @param `src`: The source pixels
+// @param `dst`: The destination pixels (may alias `src`)
+// @param `width`, `height`: The image size
+// @param `channels`: The number of channels per pixel
+// @param `sigma`: The standard deviation in pixels
+// @param `finish`: Maps a source sample and its blurred value to the destination sample
+template <typename T, typename Finish>
+static void blurLayout(const T* src, T* dst, int width, int height, int channels, float sigma, Finish finish) {
+  if (width <= 0 || height <= 0) return;
+  const GaussianCoefficients g(sigma);
+  const int threads = getThreadCount();
+  const size_t rowSamples = static_cast<size_t>(width) * channels;
+  const bool alpha = channels == 2 || channels == 4;
+  const int colors = alpha ? channels - 1 : channels;
+  FloatBuffer plane(rowSamples * height);
+
+  // Vertical pass on strips of columns, into a float plane
+  const size_t strips = (rowSamples + GAUSSIAN_STRIP - 1) / GAUSSIAN_STRIP;
+  runJobs(strips, threads, [&](size_t strip) {
+    const size_t begin = strip * GAUSSIAN_STRIP;
+    const size_t lanes = std::min(GAUSSIAN_STRIP, rowSamples - begin);
+    LineBuffer lines(lanes * height);
+    for (int y = 0; y < height; ++y) {
+      const T* in = src + y * rowSamples + begin;
+      std::copy(in, in + lanes, lines.data() + y * lanes);
+    }
+    recurseLines(lines.data(), height, lanes, g);
+    for (int y = 0; y < height; ++y) {
+      const double* in = lines.data() + y * lanes;
+      std::copy(in, in + lanes, plane.data() + y * rowSamples + begin);
+    }
+  });
+
+  // Horizontal pass on transposed blocks of rows, fused with the final combination
+  const size_t blocks = (height + GAUSSIAN_BLOCK_ROWS - 1) / GAUSSIAN_BLOCK_ROWS;
+  runJobs(blocks, threads, [&](size_t block) {
+    const int first = static_cast<int>(block) * GAUSSIAN_BLOCK_ROWS;
+    const int rows = std::min(GAUSSIAN_BLOCK_ROWS, height - first);
+    const size_t lanes = static_cast<size_t>(rows) * channels;
+    LineBuffer lines(lanes * width);
+    for (int x = 0; x < width; ++x) {
+      double* out = lines.data() + x * lanes;
+      for (int r = 0; r < rows; ++r, out += channels) {
+        const float* in = plane.data() + (first + r) * rowSamples + x * channels;
+        std::copy(in, in + channels, out);
+      }
+    }
+    recurseLines(lines.data(), width, lanes, g);
+    for (int x = 0; x < width; ++x) {
+      const double* in = lines.data() + x * lanes;
+      for (int r = 0; r < rows; ++r, in += channels) {
+        const size_t i = (first + r) * rowSamples + x * channels;
+        for (int c = 0; c < colors; ++c) dst[i + c] = finish(src[i + c], in[c]);
+        if (alpha) dst[i + colors] = src[i + colors]; // Alpha is kept as is
+      }
+    }
+  });
+}
+
+/////////////////// IMAGE FILTERS ///////////////////////
+
+// @brief: Blurs an image with a recursive Gaussian
+// @param `src`: The source pixels
+// @param `dst`: The destination pixels (may alias `src`)
+// @param `width`, `height`: The image size
+// @param `channels`: The number of channels per pixel
+// @param `sigma`: The standard deviation in pixels
+template <typename T>
+void gaussianPixels(const T* src, T* dst, int width, int height, int channels, float sigma) {
+  blurLayout(src, dst, width, height, channels, sigma, [](T, double blurred) { return toSample<T>(blurred); });
+}
+
+// @brief: Sharpens an image with an unsharp mask
+// The mask is the difference between a sample and its Gaussian blur. It is scaled by `amount` and
+// added back wherever it reaches `threshold`, in the same pass that finishes the blur.
+// @param `src`: The source pixels
+// @param `dst`: The destination pixels (may alias `src`)
+// @param `width`, `height`: The image size
+// @param `channels`: The number of channels per pixel
+// @param `radius`: The standard deviation of the blur in pixels
+// @param `amount`: The strength of the mask
+// @param `threshold`: The smallest difference that is sharpened, in 8-bit levels
+template <typename T>
+void unsharpPixels(const T* src, T* dst, int width, int height, int channels, float radius, float amount, float threshold) {
+  const double scaled = threshold * (SampleTraits<T>::max / 255.0);
+  blurLayout(src, dst, width, height, channels, radius, [&](T sample, double blurred) {
+    const double mask = sample - blurred;
+    return std::fabs(mask) < scaled ? sample : toSample<T>(sample + amount * mask);
+  });
+}
+
+/////////////////// INSTANTIATIONS //////////////////////
+
+template void gaussianPixels<png_byte>(const png_byte*, png_byte*, int, int, int, float);
+template void gaussianPixels<png_uint_16>(const png_uint_16*, png_uint_16*, int, int, int, float);
+template void gaussianPixels<float>(const float*, float*, int, int, int, float);
+template void unsharpPixels<png_byte>(const png_byte*, png_byte*, int, int, int, float, float, float);
+template void unsharpPixels<png_uint_16>(const png_uint_16*, png_uint_16*, int, int, int, float, float, float);
+template void unsharpPixels<float>(const float*, float*, int, int, int, float, float, float);
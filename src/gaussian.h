@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstddef>
+#include <png.h>
+
+/* Constants */
+const float GAUSSIAN_MIN_SIGMA = 0.5f;   // Smallest sigma the recursive coefficients are fitted for
+const float GAUSSIAN_MAX_SIGMA = 100.0f;
+const float UNSHARP_MAX_AMOUNT = 5.0f;
+const float UNSHARP_MAX_THRESHOLD = 255.0f; // In 8-bit levels
+const size_t GAUSSIAN_STRIP = 64;        // Samples of a row filtered together by one vertical job
+const int GAUSSIAN_BLOCK_ROWS = 16;      // Rows transposed and filtered together by one horizontal job
+
+/* Gaussian Coefficients */
+// The third-order recursive filter of Young and van Vliet, run forward and then backward.
+// `boundary` maps the last three forward outputs to the backward outputs at the end of a line,
+// which match a line extended with its last sample (Triggs and Sdika).
+struct GaussianCoefficients {
+  double gain;
+  double a1;
+  double a2;
+  double a3;
+  double boundary[3][3];
+
+  GaussianCoefficients(float sigma);
+};
+
+/* Image Filters */
+// Blur or sharpen `width` x `height` pixels of 1 (G), 2 (GA), 3 (RGB) or 4 (RGBA) channels, leaving the alpha
+// channel untouched. The cost per pixel does not depend on sigma or the radius.
+// Instantiated for png_byte (8-bit), png_uint_16 (16-bit) and float samples.
+template <typename T> void gaussianPixels(const T* src, T* dst, int width, int height, int channels, float sigma);
+template <typename T> void unsharpPixels(const T* src, T* dst, int width, int height, int channels, float radius, float amount, float threshold);
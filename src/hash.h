@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/* Constants */
+const uint64_t HASH_SEED = 14695981039346656037ull; // FNV-1a offset basis, the hash of no bytes
+
+// @brief: Mixes bytes into an FNV-1a hash
+// @param `hash`: The hash so far, HASH_SEED to start one
+// @param `data`: The bytes to mix in
+// @param `size`: The number of bytes
+// @return: The hash with the bytes mixed in
+inline uint64_t mixHash(uint64_t hash, const void* data, size_t size) {
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= 1099511628211ull; // FNV-1a prime
+  }
+  return hash;
+}
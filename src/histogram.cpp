@@ -0,0 +1,170 @@
+#include <mutex>
+#include <algorithm>
+#include "histogram.h"
+#include "parallel.h"
+
+/////////////////// HISTOGRAM HELPERS ///////////////////
+
+// @brief: Returns the number of samples per pixel of a PNG color type
+static int getLayoutChannels(int colorType) {
+  switch (colorType) {
+    case PNG_COLOR_TYPE_GRAY_ALPHA: return 2;
+    case PNG_COLOR_TYPE_RGB: return 3;
+    case PNG_COLOR_TYPE_RGBA: return 4;
+    default: return 1; // Gray and palette indices
+  }
+}
+
+// @brief: Counts the samples of a row into four sub-histograms
+// Consecutive pixels go to different sub-histograms, so runs of equal samples increment
+// different counters instead of waiting on the store to the same one. The loop is unrolled
+// over the channels so that the compiler can keep the four streams apart.
+// @param `row`: The first pixel
+// @param `width`: The number of pixels
+// @param `sub`: Four sub-histograms of C * HISTOGRAM_BINS counters
+template <typename T, int C>
+static void countRow(const T* row, int width, uint32_t* sub) {
+  constexpr int shift = sizeof(T) == 2 ? 8 : 0; // Bin 16-bit samples by their high byte
+  uint32_t* h0 = sub;
+  uint32_t* h1 = sub + C * HISTOGRAM_BINS;
+  uint32_t* h2 = sub + 2 * C * HISTOGRAM_BINS;
+  uint32_t* h3 = sub + 3 * C * HISTOGRAM_BINS;
+  int x = 0;
+  for (; x + 4 <= width; x += 4, row += 4 * C) {
+    for (int c = 0; c < C; ++c) {
+      h0[c * HISTOGRAM_BINS + (row[c] >> shift)]++;
+      h1[c * HISTOGRAM_BINS + (row[C + c] >> shift)]++;
+      h2[c * HISTOGRAM_BINS + (row[2 * C + c] >> shift)]++;
+      h3[c * HISTOGRAM_BINS + (row[3 * C + c] >> shift)]++;
+    }
+  }
+  for (; x < width; ++x, row += C) {
+    for (int c = 0; c < C; ++c) h0[c * HISTOGRAM_BINS + (row[c] >> shift)]++;
+  }
+}
+
+// @brief: Counts a band of rows with the kernel specialized for the layout
+template <typename T>
+static void countBand(const png_byte* data, size_t rowBytes, int channels, int x, int y, int width, int height, uint32_t* sub) {
+  for (int r = y; r < y + height; ++r) {
+    const T* row = reinterpret_cast<const T*>(data + r * rowBytes) + static_cast<size_t>(x) * channels;
+    switch (channels) {
+      case 1: countRow<T, 1>(row, width, sub); break;
+      case 2: countRow<T, 2>(row, width, sub); break;
+      case 3: countRow<T, 3>(row, width, sub); break;
+      default: countRow<T, 4>(row, width, sub); break;
+    }
+  }
+}
+
+/////////////////// HISTOGRAM CONSTRUCTOR ///////////////
+
+// @brief: Initializes an empty histogram
+Histogram::Histogram(void) {
+  this->channels = 0;
+  this->pixels = 0;
+  this->threads = getThreadCount();
+}
+
+/////////////////// HISTOGRAM PRIVATE METHODS ///////////
+
+// @brief: Adds or removes the counts of a region
+// Bands of rows are counted on several threads; every band merges its sub-histograms
+// into the totals once, under a lock.
+// @param `source`: The image
+// @param `region`: The pixels to count
+// @param `add`: Whether to add the counts, or remove them
+void Histogram::accumulate(const HistogramSource& source, const HistogramRegion& region, bool add) {
+  const int layoutChannels = getLayoutChannels(source.colorType);
+  const size_t rowBytes = static_cast<size_t>(source.width) * layoutChannels * (source.bitDepth / 8);
+  const size_t bands = (region.height + HISTOGRAM_BAND_ROWS - 1) / HISTOGRAM_BAND_ROWS;
+  const size_t tableSize = static_cast<size_t>(layoutChannels) * HISTOGRAM_BINS;
+  std::vector<uint64_t> totals(tableSize, 0);
+  std::mutex lock;
+
+  runJobs(bands, this->threads, [&](size_t band) {
+    std::vector<uint32_t> sub(4 * tableSize, 0);
+    int y = region.y + static_cast<int>(band) * HISTOGRAM_BAND_ROWS;
+    int height = std::min(HISTOGRAM_BAND_ROWS, region.y + region.height - y);
+    if (source.bitDepth == 16) countBand<png_uint_16>(source.data, rowBytes, layoutChannels, region.x, y, region.width, height, sub.data());
+    else countBand<png_byte>(source.data, rowBytes, layoutChannels, region.x, y, region.width, height, sub.data());
+
+    std::lock_guard<std::mutex> guard(lock);
+    for (size_t i = 0; i < tableSize; ++i) totals[i] += static_cast<uint64_t>(sub[i]) + sub[tableSize + i] + sub[2 * tableSize + i] + sub[3 * tableSize + i];
+  });
+
+  // Indexed images count their indices, which are then looked up in the palette
+  if (source.colorType == PNG_COLOR_TYPE_PALETTE) {
+    std::vector<uint64_t> colors(static_cast<size_t>(this->channels) * HISTOGRAM_BINS, 0);
+    for (int i = 0; i < HISTOGRAM_BINS; ++i) {
+      if (!totals[i]) continue;
+      const png_color color = i < source.paletteSize ? source.palette[i] : png_color{ 0, 0, 0 };
+      colors[0 * HISTOGRAM_BINS + color.red] += totals[i];
+      colors[1 * HISTOGRAM_BINS + color.green] += totals[i];
+      colors[2 * HISTOGRAM_BINS + color.blue] += totals[i];
+      if (this->channels == 4) colors[3 * HISTOGRAM_BINS + (i < source.transSize ? source.trans[i] : 255)] += totals[i];
+    }
+    totals.swap(colors);
+  }
+
+  // Removing wraps around, which is exact since the counts never drop below zero
+  const uint64_t count = static_cast<uint64_t>(region.width) * region.height;
+  for (size_t i = 0; i < totals.size(); ++i) this->counts[i] += add ? totals[i] : 0 - totals[i];
+  this->pixels += add ? count : 0 - count;
+}
+
+/////////////////// HISTOGRAM METHODS ///////////////////
+
+// @brief: Counts every pixel of an image
+// @param `source`: The image
+void Histogram::compute(const HistogramSource& source) {
+  this->channels = source.colorType == PNG_COLOR_TYPE_PALETTE ? (source.transSize > 0 ? 4 : 3) : getLayoutChannels(source.colorType);
+  this->pixels = 0;
+  this->counts.assign(static_cast<size_t>(this->channels) * HISTOGRAM_BINS, 0);
+  if (!source.data || source.width <= 0 || source.height <= 0) return;
+  this->accumulate(source, { 0, 0, source.width, source.height }, true);
+}
+
+// @brief: Recounts only the regions that an edit changed
+// Both sides must have the same layout and palette; otherwise call compute.
+// @param `before`: The image before the edit
+// @param `after`: The image after the edit
+// @param `regions`: The regions the edit changed
+void Histogram::update(const HistogramSource& before, const HistogramSource& after, const std::vector<HistogramRegion>& regions) {
+  for (const HistogramRegion& region : regions) {
+    this->accumulate(before, region, false);
+    this->accumulate(after, region, true);
+  }
+}
+
+// @brief: Drops every count
+void Histogram::clear(void) {
+  this->channels = 0;
+  this->pixels = 0;
+  this->counts.clear();
+}
+
+/////////////////// HISTOGRAM GETTERS ///////////////////
+
+int Histogram::getChannels(void) const { return this->channels; }
+uint64_t Histogram::getPixels(void) const { return this->pixels; }
+const uint64_t* Histogram::getCounts(int channel) const { return &this->counts[static_cast<size_t>(channel) * HISTOGRAM_BINS]; }
+int Histogram::getMin(int channel) const {
+  const uint64_t* counts = this->getCounts(channel);
+  for (int i = 0; i < HISTOGRAM_BINS; ++i) if (counts[i]) return i;
+  return 0;
+}
+int Histogram::getMax(int channel) const {
+  const uint64_t* counts = this->getCounts(channel);
+  for (int i = HISTOGRAM_BINS - 1; i >= 0; --i) if (counts[i]) return i;
+  return 0;
+}
+float Histogram::getMean(int channel) const {
+  if (!this->pixels) return 0.0f;
+  const uint64_t* counts = this->getCounts(channel);
+  double sum = 0;
+  for (int i = 0; i < HISTOGRAM_BINS; ++i) sum += static_cast<double>(i) * counts[i];
+  return static_cast<float>(sum / this->pixels);
+}
+float Histogram::getClippedLow(int channel) const { return this->pixels ? static_cast<float>(this->getCounts(channel)[0]) / this->pixels : 0.0f; }
+float Histogram::getClippedHigh(int channel) const { return this->pixels ? static_cast<float>(this->getCounts(channel)[HISTOGRAM_BINS - 1]) / this->pixels : 0.0f; }
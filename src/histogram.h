@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <png.h>
+
+/* Constants */
+const int HISTOGRAM_BINS = 256;             // Bins per channel; 16-bit samples are binned by their high byte
+const int HISTOGRAM_BAND_ROWS = 64;         // Rows counted by one job
+const float HISTOGRAM_CLIP_WARNING = 0.01f; // Fraction of clipped samples that triggers a warning
+
+/* Histogram Source */
+// The pixel data and layout of the image to count
+struct HistogramSource {
+  const png_byte* data;
+  int width;
+  int height;
+  int bitDepth;
+  int colorType;
+  const png_color* palette;
+  int paletteSize;
+  const png_byte* trans;
+  int transSize;
+};
+
+/* Histogram Region */
+// A rectangle of pixels
+struct HistogramRegion {
+  int x;
+  int y;
+  int width;
+  int height;
+};
+
+class Histogram {
+private:
+  /* Private Variables */
+  int channels; // 1 (G), 2 (GA), 3 (RGB) or 4 (RGBA); indexed images are counted as RGB(A)
+  uint64_t pixels;
+  std::vector<uint64_t> counts;
+  int threads;
+
+  /* Private Methods */
+  void accumulate(const HistogramSource& source, const HistogramRegion& region, bool add);
+
+public:
+  /* Constructor */
+  Histogram(void);
+
+  /* Methods */
+  void compute(const HistogramSource& source);
+  void update(const HistogramSource& before, const HistogramSource& after, const std::vector<HistogramRegion>& regions);
+  void clear(void);
+
+  /* Getters */
+  int getChannels(void) const;
+  uint64_t getPixels(void) const;
+  const uint64_t* getCounts(int channel) const;
+  int getMin(int channel) const;
+  int getMax(int channel) const;
+  float getMean(int channel) const;
+  float getClippedLow(int channel) const;
+  float getClippedHigh(int channel) const;
+};
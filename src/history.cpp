@@ -0,0 +1,247 @@
+#include <iostream>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <zlib.h>
+#include "history.h"
+#include "parallel.h"
+
+/////////////////// HISTORY HELPERS /////////////////////
+
+// @brief: Compresses a buffer with the fastest zlib level
+// @return: Whether the buffer was compressed
+static bool compressBuffer(const png_byte* data, size_t size, PixelBuffer& out) {
+  uLongf length = compressBound(static_cast<uLong>(size));
+  out.resize(length);
+  if (compress2(out.data(), &length, data, static_cast<uLong>(size), Z_BEST_SPEED) != Z_OK) return false;
+  out.resize(length);
+  out.shrink_to_fit();
+  return true;
+}
+
+// @brief: Decompresses a buffer of a known size
+// @return: Whether the buffer was decompressed
+static bool decompressBuffer(const PixelBuffer& data, png_byte* out, size_t size) {
+  uLongf length = static_cast<uLongf>(size);
+  return uncompress(out, &length, data.data(), static_cast<uLong>(data.size())) == Z_OK && length == size;
+}
+
+// @brief: Returns whether two palettes have the same entries
+static bool samePalette(const std::vector<png_color>& a, const std::vector<png_color>& b) {
+  return a.size() == b.size() && (a.empty() || std::memcmp(a.data(), b.data(), a.size() * sizeof(png_color)) == 0);
+}
+
+/////////////////// HISTORY STATE ///////////////////////
+
+bool HistoryState::operator==(const HistoryState& other) const {
+  return this->operations == other.operations && this->colorType == other.colorType && samePalette(this->palette, other.palette) && this->trans == other.trans;
+}
+
+/////////////////// HISTORY CONSTRUCTOR /////////////////
+
+// @brief: Initializes an empty history
+// @param `budget`: The most memory the compressed entries may use
+History::History(size_t budget) {
+  this->position = 0;
+  this->bytes = 0;
+  this->budget = budget;
+  this->threads = getThreadCount();
+}
+
+/////////////////// HISTORY PRIVATE METHODS /////////////
+
+// @brief: XORs the tile deltas of an entry into the pixel data, which undoes or redoes the edit
+// XOR is its own inverse, so when a tile fails to decompress the tiles already applied are XORed
+// again and the data is left as it was.
+// @param `entry`: The entry to apply
+// @param `data`: The pixel data on one side of the entry
+// @param `regions`: If set, receives the block of every tile
+// @return: Whether every tile was applied
+bool History::applyTiles(const Entry& entry, PixelBuffer& data, std::vector<HistoryRegion>* regions) const {
+  std::vector<char> applied(entry.tiles.size(), 0);
+  auto apply = [&](size_t i) {
+    const Tile& tile = entry.tiles[i];
+    const int rows = std::min(HISTORY_TILE_SIZE, entry.height - tile.row);
+    const size_t columns = std::min(entry.tileBytes, entry.rowBytes - tile.column);
+    PixelBuffer delta(rows * columns);
+    if (!decompressBuffer(tile.delta, delta.data(), delta.size())) return false;
+    for (int r = 0; r < rows; ++r) {
+      png_byte* out = &data[(tile.row + r) * entry.rowBytes + tile.column];
+      const png_byte* in = &delta[r * columns];
+      for (size_t c = 0; c < columns; ++c) out[c] ^= in[c];
+    }
+    return true;
+  };
+  runJobs(entry.tiles.size(), this->threads, [&](size_t i) { applied[i] = apply(i); });
+
+  if (std::find(applied.begin(), applied.end(), 0) != applied.end()) {
+    std::cerr << "Failed to decompress history tile" << std::endl;
+    runJobs(entry.tiles.size(), this->threads, [&](size_t i) { if (applied[i]) apply(i); });
+    return false;
+  }
+  if (regions) {
+    for (const Tile& tile : entry.tiles) {
+      regions->push_back({ tile.row, std::min(HISTORY_TILE_SIZE, entry.height - tile.row), tile.column, std::min(entry.tileBytes, entry.rowBytes - tile.column) });
+    }
+  }
+  return true;
+}
+
+// @brief: Replaces the pixel data with a whole compressed buffer
+// @param `compressed`: The compressed buffer
+// @param `size`: The size of the buffer once decompressed
+// @param `data`: The pixel data, left as it was if the buffer fails to decompress
+// @return: Whether the buffer was decompressed
+bool History::applyBuffer(const PixelBuffer& compressed, size_t size, PixelBuffer& data) const {
+  PixelBuffer restored(size, data.get_allocator());
+  if (!decompressBuffer(compressed, restored.data(), restored.size())) {
+    std::cerr << "Failed to decompress history entry" << std::endl;
+    return false;
+  }
+  data.swap(restored);
+  return true;
+}
+
+// @brief: Drops the oldest entries until the history fits in its budget
+// Entries that can be redone are dropped from the newest end instead, since they build on the current state
+void History::trim(void) {
+  while (this->bytes > this->budget && !this->entries.empty()) {
+    if (this->position > 0) {
+      this->bytes -= this->entries.front().bytes;
+      this->entries.pop_front();
+      --this->position;
+    } else {
+      this->bytes -= this->entries.back().bytes;
+      this->entries.pop_back();
+    }
+  }
+}
+
+/////////////////// HISTORY METHODS /////////////////////
+
+// @brief: Records an edit and drops the entries that could be redone
+// Only the tiles that changed are stored, as compressed XORs of their old and new bytes,
+// so an entry grows with how much of the image the edit touched.
+// @param `before`, `beforeData`: The image before the edit
+// @param `after`, `afterData`: The image after the edit
+// @param `width`, `height`: The image size
+void History::record(const HistoryState& before, const PixelBuffer& beforeData, const HistoryState& after, const PixelBuffer& afterData, int width, int height) {
+  Entry entry;
+  entry.before = before;
+  entry.after = after;
+  entry.height = height;
+  entry.rowBytes = height > 0 ? afterData.size() / height : 0;
+  entry.tileBytes = HISTORY_TILE_SIZE * (width > 0 ? std::max<size_t>(1, entry.rowBytes / width) : 1);
+  entry.beforeSize = beforeData.size();
+  entry.afterSize = afterData.size();
+  entry.bytes = (before.palette.size() + after.palette.size()) * sizeof(png_color) + before.trans.size() + after.trans.size();
+
+  bool ok = true;
+  const bool sameLayout = before.colorType == after.colorType && beforeData.size() == afterData.size();
+  if (sameLayout) {
+    // Find the tiles that changed and compress their XOR
+    std::vector<Tile> tiles;
+    for (int row = 0; row < height; row += HISTORY_TILE_SIZE) {
+      for (size_t column = 0; column < entry.rowBytes; column += entry.tileBytes) tiles.push_back({ row, column });
+    }
+    std::atomic<bool> failed(false);
+    runJobs(tiles.size(), this->threads, [&](size_t i) {
+      Tile& tile = tiles[i];
+      const int rows = std::min(HISTORY_TILE_SIZE, height - tile.row);
+      const size_t columns = std::min(entry.tileBytes, entry.rowBytes - tile.column);
+      bool changed = false;
+      for (int r = 0; r < rows && !changed; ++r) {
+        size_t offset = (tile.row + r) * entry.rowBytes + tile.column;
+        changed = std::memcmp(&beforeData[offset], &afterData[offset], columns) != 0;
+      }
+      if (!changed) return;
+
+      PixelBuffer delta(rows * columns);
+      for (int r = 0; r < rows; ++r) {
+        size_t offset = (tile.row + r) * entry.rowBytes + tile.column;
+        for (size_t c = 0; c < columns; ++c) delta[r * columns + c] = beforeData[offset + c] ^ afterData[offset + c];
+      }
+      if (!compressBuffer(delta.data(), delta.size(), tile.delta)) failed = true;
+    });
+    ok = !failed;
+    for (Tile& tile : tiles) {
+      if (tile.delta.empty()) continue;
+      entry.bytes += tile.delta.size() + sizeof(Tile);
+      entry.tiles.push_back(std::move(tile));
+    }
+
+    // Nothing changed
+    if (ok && entry.tiles.empty() && before == after) return;
+  } else {
+    // The buffers no longer line up, so both sides are kept whole
+    ok = compressBuffer(beforeData.data(), beforeData.size(), entry.beforeData) && compressBuffer(afterData.data(), afterData.size(), entry.afterData);
+    entry.bytes += entry.beforeData.size() + entry.afterData.size();
+  }
+
+  // Every entry builds on the one before it, so a lost entry breaks the whole chain
+  if (!ok) {
+    std::cerr << "Failed to compress history entry" << std::endl;
+    this->clear();
+    return;
+  }
+
+  while (this->entries.size() > this->position) {
+    this->bytes -= this->entries.back().bytes;
+    this->entries.pop_back();
+  }
+  this->bytes += entry.bytes;
+  this->entries.push_back(std::move(entry));
+  this->position = this->entries.size();
+  this->trim();
+}
+
+// @brief: Steps back one entry
+// @param `state`: The image state, set to the state before the edit
+// @param `data`: The pixel data after the edit, turned into the data before it
+// @param `regions`: If set, receives the blocks that changed; left empty when the whole buffer was replaced
+// @return: Whether an edit was undone; the state, data and position are left as they were if it could not be restored
+bool History::undo(HistoryState& state, PixelBuffer& data, std::vector<HistoryRegion>* regions) {
+  if (!this->canUndo()) return false;
+  const Entry& entry = this->entries[this->position - 1];
+  const bool applied = entry.beforeData.empty() ? this->applyTiles(entry, data, regions) : this->applyBuffer(entry.beforeData, entry.beforeSize, data);
+  if (!applied) return false;
+  state = entry.before;
+  --this->position;
+  return true;
+}
+
+// @brief: Steps forward one entry
+// @param `state`: The image state, set to the state after the edit
+// @param `data`: The pixel data before the edit, turned into the data after it
+// @param `regions`: If set, receives the blocks that changed; left empty when the whole buffer was replaced
+// @return: Whether an edit was redone; the state, data and position are left as they were if it could not be restored
+bool History::redo(HistoryState& state, PixelBuffer& data, std::vector<HistoryRegion>* regions) {
+  if (!this->canRedo()) return false;
+  const Entry& entry = this->entries[this->position];
+  const bool applied = entry.afterData.empty() ? this->applyTiles(entry, data, regions) : this->applyBuffer(entry.afterData, entry.afterSize, data);
+  if (!applied) return false;
+  state = entry.after;
+  ++this->position;
+  return true;
+}
+
+// @brief: Drops every entry
+void History::clear(void) {
+  this->entries.clear();
+  this->position = 0;
+  this->bytes = 0;
+}
+
+/////////////////// HISTORY GETTERS /////////////////////
+
+bool History::canUndo(void) const { return this->position > 0; }
+bool History::canRedo(void) const { return this->position < this->entries.size(); }
+size_t History::getBytes(void) const { return this->bytes; }
+size_t History::getBudget(void) const { return this->budget; }
+
+/////////////////// HISTORY SETTERS /////////////////////
+
+void History::setBudget(size_t budget) {
+  this->budget = budget;
+  this->trim();
+}
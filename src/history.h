@@ -0,0 +1,89 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <png.h>
+#include "pipeline.h"
+#include "memory_tracker.h"
+
+/* Constants */
+const size_t HISTORY_BUDGET_BYTES = 256 << 20; // Default memory budget of the compressed history
+const int HISTORY_TILE_SIZE = 128;             // Tile width and height in pixels
+
+/* History State */
+// Everything about an image that an edit can change, besides its pixel data
+struct HistoryState {
+  std::vector<Operation> operations;
+  int colorType;
+  std::vector<png_color> palette;
+  std::vector<png_byte> trans;
+
+  bool operator==(const HistoryState& other) const;
+};
+
+/* History Region */
+// A block of pixel data that an undo or redo changed
+struct HistoryRegion {
+  int row;       // First row
+  int rows;
+  size_t column; // First byte in each row
+  size_t bytes;  // Bytes in each row
+};
+
+class History {
+private:
+  /* Private Types */
+  // A compressed XOR of the pixel data of one tile before and after an edit
+  struct Tile {
+    int row;       // First row of the tile
+    size_t column; // First byte of the tile in each row
+    PixelBuffer delta{ MemoryCategory::HISTORY };
+  };
+
+  // One edit; the pixel data is either tiles of XOR deltas, or whole compressed buffers
+  // when the edit changed the pixel layout and the buffers no longer line up
+  struct Entry {
+    HistoryState before;
+    HistoryState after;
+    int height;
+    size_t rowBytes;
+    size_t tileBytes;
+    std::vector<Tile> tiles;
+    PixelBuffer beforeData{ MemoryCategory::HISTORY };
+    PixelBuffer afterData{ MemoryCategory::HISTORY };
+    size_t beforeSize;
+    size_t afterSize;
+    size_t bytes;
+  };
+
+  /* Private Variables */
+  std::deque<Entry> entries;
+  size_t position; // Number of entries that can be undone
+  size_t bytes;
+  size_t budget;
+  int threads;
+
+  /* Private Methods */
+  bool applyTiles(const Entry& entry, PixelBuffer& data, std::vector<HistoryRegion>* regions) const;
+  bool applyBuffer(const PixelBuffer& compressed, size_t size, PixelBuffer& data) const;
+  void trim(void);
+
+public:
+  /* Constructor */
+  History(size_t budget = HISTORY_BUDGET_BYTES);
+
+  /* Methods */
+  void record(const HistoryState& before, const PixelBuffer& beforeData, const HistoryState& after, const PixelBuffer& afterData, int width, int height);
+  bool undo(HistoryState& state, PixelBuffer& data, std::vector<HistoryRegion>* regions = nullptr);
+  bool redo(HistoryState& state, PixelBuffer& data, std::vector<HistoryRegion>* regions = nullptr);
+  void clear(void);
+
+  /* Getters */
+  bool canUndo(void) const;
+  bool canRedo(void) const;
+  size_t getBytes(void) const;
+  size_t getBudget(void) const;
+
+  /* Setters */
+  void setBudget(size_t budget);
+};
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <cstdint>
+#include <glad/glad.h>
+#include "icon_atlas.h"
+#include "memory_tracker.h"
+
+/////////////////// ICON ATLAS CONSTRUCTOR //////////////
+
+// @brief: Initializes the atlas without a texture
+IconAtlas::IconAtlas(void) {
+  this->texture = nullptr;
+}
+
+/////////////////// ICON ATLAS DESTRUCTOR ///////////////
+
+// @brief: Deallocates the atlas texture
+IconAtlas::~IconAtlas(void) {
+  if (!this->texture) return;
+  GLuint textureID = (GLuint)(intptr_t)this->texture;
+  glDeleteTextures(1, &textureID);
+  MemoryTracker::get().remove(MemoryCategory::TEXTURE, sizeof(ICON_ATLAS_PIXELS));
+}
+
+/////////////////// ICON ATLAS METHODS //////////////////
+
+// @brief: Uploads the embedded atlas as a single texture
+void IconAtlas::createOpenGLTexture(void) {
+  GLuint textureID;
+  glGenTextures(1, &textureID);
+  if (!textureID) {
+    std::cerr << "Failed to create OpenGL texture" << std::endl;
+    exit(1);
+  }
+  glBindTexture(GL_TEXTURE_2D, textureID);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, ICON_ATLAS_WIDTH, ICON_ATLAS_HEIGHT, 0, GL_RGBA, GL_UNSIGNED_BYTE, ICON_ATLAS_PIXELS);
+  if (glGetError() != GL_NO_ERROR) {
+    std::cerr << "Failed to set OpenGL texture data" << std::endl;
+    exit(1);
+  }
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  MemoryTracker::get().add(MemoryCategory::TEXTURE, sizeof(ICON_ATLAS_PIXELS));
+
+  this->texture = reinterpret_cast<ImTextureID>(static_cast<intptr_t>(textureID));
+}
+
+// @brief: Draws an image button showing one icon
+// Every button shares the atlas texture, which ImGui would otherwise use as the ID of all of them
+// @param `icon`: The icon
+// @param `size`: The size of the button image
+// @return: Whether the button was pressed
+bool IconAtlas::button(const IconRect& icon, const ImVec2& size) const {
+  ImGui::PushID(&icon);
+  bool pressed = ImGui::ImageButton(this->texture, size, ImVec2(icon.u0, icon.v0), ImVec2(icon.u1, icon.v1));
+  ImGui::PopID();
+  return pressed;
+}
+
+/////////////////// ICON ATLAS GETTERS //////////////////
+
+ImTextureID IconAtlas::getTexture(void) const { return this->texture; }
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <imgui.h>
+
+/* Icon Rect */
+// The UV sub-rectangle of one icon in the atlas
+struct IconRect {
+  float u0;
+  float v0;
+  float u1;
+  float v1;
+};
+
+// The atlas pixels and one IconRect per icon, generated from assets/ at build time by tools/embed_icons.cpp
+#include "icon_atlas_data.h"
+
+class IconAtlas {
+private:
+  /* Private Variables */
+  ImTextureID texture;
+
+public:
+  /* Constructor */
+  IconAtlas(void);
+
+  /* Destructor */
+  ~IconAtlas(void);
+
+  /* Methods */
+  void createOpenGLTexture(void);
+  bool button(const IconRect& icon, const ImVec2& size) const;
+
+  /* Getters */
+  ImTextureID getTexture(void) const;
+};
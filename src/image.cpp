@@ -1,12 +1,52 @@
 #include <iostream>
 #include <fstream>
 #include <memory>
+#include <algorithm>
+#include <cstring>
+#include <type_traits>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <imgui.h>
 #include <backends/imgui_impl_glfw.h>
 #include <backends/imgui_impl_opengl3.h>
 #include "image.h"
+#include "encoder.h"
+#include "filters.h"
+#include "gaussian.h"
+#include "median.h"
+#include "bilateral.h"
+#include "mapped_file.h"
+#include "decode_cache.h"
+#include "file_key.h"
+#include "profiler.h"
+
+/////////////////// IMAGE HELPERS ///////////////////////
+
+// @brief: Calls `function` with the pixel data viewed as samples of the given bit depth
+// @param `data`: The pixel data
+// @param `bitDepth`: 8 or 16; 16-bit samples are stored in host byte order
+// @param `function`: A generic callable taking a png_byte* or png_uint_16* pointer
+template <typename Data, typename Function>
+static void withSamples(Data& data, int bitDepth, Function function) {
+  if (bitDepth == 16) function(reinterpret_cast<png_uint_16*>(data.data()));
+  else function(data.data());
+}
+
+// @brief: Returns whether 16-bit samples are stored least significant byte first
+static bool isLittleEndian(void) {
+  const png_uint_16 probe = 1;
+  return *reinterpret_cast<const png_byte*>(&probe) == 1;
+}
+
+// @brief: libpng row callback that reports progress and aborts cancelled loads
+// @param `png`: The PNG read struct whose error pointer is the load progress
+static void onRowRead(png_structp png, png_uint_32 row, int pass) {
+  (void)row;
+  (void)pass;
+  LoadProgress* progress = static_cast<LoadProgress*>(png_get_error_ptr(png));
+  progress->rows++;
+  if (progress->cancel) png_error(png, "Load cancelled");
+}
 
 /////////////////// IMAGE CONSTRUCTOR ///////////////////
 
@@ -18,17 +58,21 @@ Image::Image(void) {
   this->height = 0;
   this->bitDepth = 0;
   this->colorType = 0;
-  this->originalData = std::vector<png_byte>();
-  this->data = std::vector<png_byte>();
+  this->originalColorType = 0;
+  this->originalData = PixelBuffer(MemoryCategory::IMAGE);
+  this->data = PixelBuffer(MemoryCategory::IMAGE);
+  this->originalPalette = std::vector<png_color>();
+  this->palette = std::vector<png_color>();
+  this->originalTrans = std::vector<png_byte>();
+  this->trans = std::vector<png_byte>();
   this->texture = nullptr;
-  this->_invert = false;
-  this->_grayscale = false;
-  this->_blur = false;
-  this->_sharpen = false;
-  this->red = 1.0f;
-  this->green = 1.0f;
-  this->blue = 1.0f;
-  this->rotateAngle = 0;
+  this->textureBytes = 0;
+  this->histogramValid = false;
+  this->progressiveDone = false;
+  this->overBudget = false;
+  this->cacheDecoded = true;
+  this->committedData = PixelBuffer(MemoryCategory::HISTORY);
+  this->committedState = this->getState();
 }
 
 /////////////////// IMAGE DESTRUCTOR ////////////////////
@@ -36,28 +80,38 @@ Image::Image(void) {
 // @brief: Deallocates the image class
 Image::~Image(void) {
   // Deallocate image
-  glDeleteTextures(1, (GLuint*)(intptr_t)this->texture);
-  delete this;
+  this->releaseOpenGLTexture();
 }
 
 /////////////////// IMAGE METHODS ///////////////////////
 
 // @brief: Loads an image from a file into memory
 // @param `path`: The path to the image file
-void Image::load(const std::string path) {
+// @param `progress`: Optional progress report and cancel flag, for loading on another thread
+void Image::load(const std::string path, LoadProgress* progress) {
+  ScopedTimer timer("Load");
+
   // Set the path
   this->path = path;
 
-  // Open the file
-  FILE* fp = fopen(this->path.c_str(), "rb");
-  if (!fp) {
-    std::cerr << "Failed to open for reading: " << this->path << std::endl;
+  // Copy the pixels of a file decoded before, unless it changed since
+  const std::string key = getFileKey(this->path);
+  if (this->loadDecoded(key)) return;
+
+  // Map the file into memory
+  MappedFile file;
+  if (!file.open(this->path)) return;
+
+  // Interlaced images are shown pass by pass while they decode
+  const size_t interlaceOffset = 28; // Signature (8) + IHDR length and type (8) + 12 IHDR bytes
+  if (progress && file.getSize() > interlaceOffset && file.getData()[interlaceOffset] == PNG_INTERLACE_ADAM7) {
+    this->loadProgressive(file.getData(), file.getSize(), progress);
+    if (this->loaded) this->storeDecoded(key);
     return;
   }
-  std::unique_ptr<FILE, decltype(&fclose)> file(fp, fclose);
 
   // Create a PNG reader
-  png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, progress, nullptr, nullptr);
   if (!png) {
     std::cerr << "Failed to create PNG read struct" << std::endl;
     return;
@@ -73,63 +127,210 @@ void Image::load(const std::string path) {
 
   // Set up error handling
   if (setjmp(png_jmpbuf(png))) {
-    std::cerr << "Failed to set PNG jump buffer" << std::endl;
+    if (!progress || !progress->cancel) std::cerr << "Failed to set PNG jump buffer" << std::endl;
     png_destroy_read_struct(&png, &info, nullptr);
     return;
   }
 
   // Read the PNG info
-  png_init_io(png, fp);
+  file.attach(png);
   png_read_info(png, info);
-  this->width = png_get_image_width(png, info);
-  this->height = png_get_image_height(png, info);
-  this->bitDepth = png_get_bit_depth(png, info);
-  this->colorType = png_get_color_type(png, info);
-
-  // Convert non-RGBA to RGBA
-  if (this->colorType == PNG_COLOR_TYPE_GRAY || this->colorType == PNG_COLOR_TYPE_GRAY_ALPHA) png_set_gray_to_rgb(png);
-  if (this->colorType == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(png);
-  if (!(this->colorType & PNG_COLOR_MASK_ALPHA)) png_set_add_alpha(png, 0xFF, PNG_FILLER_AFTER);
-  this->colorType = PNG_COLOR_TYPE_RGBA;
+  int passes = png_set_interlace_handling(png);
+  this->setTransforms(png, info);
 
-  // Ensure 8-bit depth
-  if (this->bitDepth == 16) png_set_strip_16(png);
+  // The decoded image is kept three times: as the original, the edited image and the history base
+  if (!this->fitsBudget(this->getRowBytes() * this->height * 3)) {
+    png_destroy_read_struct(&png, &info, nullptr);
+    return;
+  }
 
-  // Update the PNG info
-  png_read_update_info(png, info);
+  // Report progress for every decoded row
+  if (progress) {
+    progress->rows = 0;
+    progress->total = this->height * passes;
+    png_set_read_status_fn(png, onRowRead);
+  }
 
   // Read the PNG image
   std::vector<png_bytep> rowPointers(this->height);
-  this->data.resize(this->width * this->height * 4);
+  this->data.resize(this->getRowBytes() * this->height);
 
   for (int y = 0; y < this->height; ++y) {
-    rowPointers[y] = &this->data[y * this->width * 4];
+    rowPointers[y] = &this->data[y * this->getRowBytes()];
   }
   png_read_image(png, rowPointers.data());
 
   // Save the original image data
-  this->originalData = this->data;
+  this->keepOriginal();
 
   // Cleanup
   png_destroy_read_struct(&png, &info, nullptr);
 
   this->loaded = true;
+  this->storeDecoded(key);
 }
 
-// @brief: Saves an image from memory to a file
-void Image::save(void) {
-  // Open the file
-  FILE* fp = fopen(this->path.c_str(), "wb");
-  if (!fp) {
-    std::cerr << "Failed to open for writing: " << this->path << std::endl;
+// @brief: Loads the image from the decode cache
+// @param `key`: The key of the file
+// @return: Whether the file was cached; it is loaded unless it is over the memory budget
+bool Image::loadDecoded(const std::string& key) {
+  DecodedImage decoded{ 0, 0, 0, 0, {}, {}, PixelBuffer(MemoryCategory::IMAGE) };
+  if (!DecodeCache::get().lookup(key, decoded)) return false;
+  this->width = decoded.width;
+  this->height = decoded.height;
+  this->bitDepth = decoded.bitDepth;
+  this->colorType = decoded.colorType;
+  this->palette = std::move(decoded.palette);
+  this->trans = std::move(decoded.trans);
+  if (!this->fitsBudget(this->getRowBytes() * this->height * 2)) return true; // The edited image is copied already
+  this->data = std::move(decoded.data);
+  this->keepOriginal();
+  this->loaded = true;
+  return true;
+}
+
+// @brief: Caches the freshly decoded image, for the next time the file is opened
+// Images whose copy would not fit in the memory budget are not cached, since the cache is only a shortcut
+// @param `key`: The key of the file, taken before it was decoded
+void Image::storeDecoded(const std::string& key) const {
+  if (!this->cacheDecoded || key.empty() || !MemoryTracker::get().fits(this->data.size())) return;
+  DecodeCache::get().store(key, { this->width, this->height, this->bitDepth, this->colorType, this->palette, this->trans, PixelBuffer(this->data, MemoryCategory::CACHE) });
+}
+
+// @brief: Returns whether `bytes` more fit in the memory budget, and reports it if they do not
+// Cached decoded files are dropped first to make room
+bool Image::fitsBudget(size_t bytes) {
+  if (!MemoryTracker::get().fits(bytes)) DecodeCache::get().release(bytes);
+  this->overBudget = !MemoryTracker::get().fits(bytes);
+  if (this->overBudget) std::cerr << "Not enough memory budget for " << bytes / (1024 * 1024) << " MB more: " << this->path << std::endl;
+  return !this->overBudget;
+}
+
+// @brief: Keeps the current image, freshly decoded or resized, as the original and starts a new history
+void Image::keepOriginal(void) {
+  this->originalData = this->data;
+  this->originalColorType = this->colorType;
+  this->originalPalette = this->palette;
+  this->originalTrans = this->trans;
+  this->pipeline.clearCache();
+  this->histogramValid = false;
+  this->history.clear();
+  this->committedData = this->data;
+  this->committedState = this->getState();
+}
+
+// @brief: Returns everything about the image that an edit can change, besides its pixel data
+HistoryState Image::getState(void) const {
+  return HistoryState{ this->pipeline.getOperations(), this->colorType, this->palette, this->trans };
+}
+
+// @brief: Restores a state returned by getState
+void Image::setState(const HistoryState& state) {
+  this->pipeline.setOperations(state.operations);
+  this->colorType = state.colorType;
+  this->palette = state.palette;
+  this->trans = state.trans;
+}
+
+// @brief: Describes pixel data in the layout of a state, for the histogram
+HistogramSource Image::getHistogramSource(const PixelBuffer& data, const HistoryState& state) const {
+  return HistogramSource{ data.data(), this->width, this->height, this->bitDepth, state.colorType,
+                          state.palette.data(), static_cast<int>(state.palette.size()), state.trans.data(), static_cast<int>(state.trans.size()) };
+}
+
+// @brief: Recounts the histogram after the history changed the committed data, only where it changed
+// Called before the committed data is copied into the image, while `data` still holds the old pixels.
+// @param `before`: The state of the old pixels
+// @param `regions`: The blocks that the history changed
+void Image::updateHistogram(const HistoryState& before, const std::vector<HistoryRegion>& regions) {
+  if (!this->histogramValid) return;
+  const HistoryState& after = this->committedState;
+  const bool sameLayout = before.colorType == after.colorType && this->data.size() == this->committedData.size() && before.trans == after.trans &&
+                          before.palette.size() == after.palette.size() &&
+                          (before.palette.empty() || std::memcmp(before.palette.data(), after.palette.data(), before.palette.size() * sizeof(png_color)) == 0);
+  if (!sameLayout || this->width <= 0) {
+    this->histogramValid = false;
     return;
   }
-  std::unique_ptr<FILE, decltype(&fclose)> file(fp, fclose);
 
-  // Create a PNG writer
-  png_structp png = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  const size_t pixelBytes = this->getRowBytes() / this->width;
+  std::vector<HistogramRegion> pixels;
+  for (const HistoryRegion& region : regions) {
+    pixels.push_back({ static_cast<int>(region.column / pixelBytes), region.row, static_cast<int>(region.bytes / pixelBytes), region.rows });
+  }
+  this->histogram.update(this->getHistogramSource(this->data, before), this->getHistogramSource(this->committedData, after), pixels);
+}
+
+// @brief: Copies what the history changed in the committed data into the image, after an undo or redo
+// Only the changed blocks are copied when the image held the committed data before and the layout is
+// unchanged; otherwise the whole buffer is.
+// @param `before`: The committed state before the history changed it
+// @param `regions`: The blocks that the history changed
+// @param `matched`: Whether the image held the committed data before
+void Image::copyCommittedRegions(const HistoryState& before, const std::vector<HistoryRegion>& regions, bool matched) {
+  const bool sameLayout = before.colorType == this->committedState.colorType && this->data.size() == this->committedData.size();
+  if (!matched || !sameLayout || this->height <= 0) {
+    this->data = this->committedData;
+    return;
+  }
+  const size_t rowBytes = this->committedData.size() / this->height;
+  for (const HistoryRegion& region : regions) {
+    for (int r = 0; r < region.rows; ++r) {
+      const size_t offset = (region.row + r) * rowBytes + region.column;
+      std::memcpy(&this->data[offset], &this->committedData[offset], region.bytes);
+    }
+  }
+}
+
+// @brief: Reads the image header and sets up the transforms applied while decoding
+// The image keeps its channel layout (G, GA, RGB, RGBA or palette indices, one per byte);
+// transparency chunks of non-indexed images become an alpha channel and sub-byte gray samples become 8-bit.
+// @param `png`: The PNG read struct
+// @param `info`: The PNG info struct, after the header has been read
+void Image::setTransforms(png_structp png, png_infop info) {
+  int colorType = png_get_color_type(png, info);
+  int bitDepth = png_get_bit_depth(png, info);
+  if (colorType == PNG_COLOR_TYPE_PALETTE) png_set_packing(png);
+  else if (png_get_valid(png, info, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(png);
+  if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8) png_set_expand_gray_1_2_4_to_8(png);
+
+  // Keep 16-bit samples in host byte order
+  if (bitDepth == 16 && isLittleEndian()) png_set_swap(png);
+
+  // Read the layout after the transforms
+  png_read_update_info(png, info);
+  this->width = png_get_image_width(png, info);
+  this->height = png_get_image_height(png, info);
+  this->bitDepth = png_get_bit_depth(png, info);
+  this->colorType = png_get_color_type(png, info);
+
+  // Keep the palette, with an alpha value for every entry if there is a tRNS chunk
+  this->palette.clear();
+  this->trans.clear();
+  if (this->colorType != PNG_COLOR_TYPE_PALETTE) return;
+  png_colorp entries = nullptr;
+  int count = 0;
+  png_get_PLTE(png, info, &entries, &count);
+  this->palette.assign(entries, entries + count);
+  png_bytep alpha = nullptr;
+  int alphaCount = 0;
+  if (png_get_tRNS(png, info, &alpha, &alphaCount, nullptr) && alpha) {
+    this->trans.assign(alpha, alpha + std::min(alphaCount, count));
+    this->trans.resize(count, 255);
+  }
+}
+
+// @brief: Loads an interlaced image with libpng's progressive reader
+// Every Adam7 pass fills the blocks it stands for, so a coarse full-frame preview
+// is ready after the first pass (1/64 of the pixels) and each pass refines it.
+// @param `file`: The PNG file contents
+// @param `size`: The PNG file size
+// @param `progress`: The progress report; `passes` counts the finished passes
+void Image::loadProgressive(const png_byte* file, size_t size, LoadProgress* progress) {
+  // Create a progressive PNG reader
+  png_structp png = png_create_read_struct(PNG_LIBPNG_VER_STRING, progress, nullptr, nullptr);
   if (!png) {
-    std::cerr << "Failed to create PNG write struct" << std::endl;
+    std::cerr << "Failed to create PNG read struct" << std::endl;
     return;
   }
 
@@ -137,30 +338,116 @@ void Image::save(void) {
   png_infop info = png_create_info_struct(png);
   if (!info) {
     std::cerr << "Failed to create PNG info struct" << std::endl;
-    png_destroy_write_struct(&png, nullptr);
+    png_destroy_read_struct(&png, nullptr, nullptr);
     return;
   }
 
   // Set up error handling
   if (setjmp(png_jmpbuf(png))) {
-    std::cerr << "Failed to set PNG jump buffer" << std::endl;
-    png_destroy_write_struct(&png, &info);
+    if (!progress->cancel) std::cerr << "Failed to decode PNG data: " << this->path << std::endl;
+    progress->lock.unlock();
+    png_destroy_read_struct(&png, &info, nullptr);
     return;
   }
 
-  // Write the PNG info
-  png_init_io(png, fp);
-  png_set_IHDR(png, info, this->width, this->height, 8, PNG_COLOR_TYPE_RGBA, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  // Feed the file in chunks, holding the lock only while pixels are written
+  const size_t chunkSize = 1 << 16;
+  this->progressiveDone = false;
+  png_set_progressive_read_fn(png, this, onProgressiveInfo, onProgressiveRow, onProgressiveEnd);
+  for (size_t offset = 0; offset < size && !this->progressiveDone; offset += chunkSize) {
+    progress->lock.lock();
+    if (progress->cancel) png_error(png, "Load cancelled");
+    png_process_data(png, info, const_cast<png_bytep>(file + offset), std::min(chunkSize, size - offset));
+    progress->lock.unlock();
+  }
+  if (!this->progressiveDone) {
+    std::cerr << "Failed to decode truncated PNG file: " << this->path << std::endl;
+    png_destroy_read_struct(&png, &info, nullptr);
+    return;
+  }
 
-  // Write the PNG image
-  std::vector<png_bytep> rowPointers(this->height);
-  for (int i = 0; i < this->height; ++i) rowPointers[i] = &this->data[i * this->width * 4];
-  png_set_rows(png, info, rowPointers.data());
-  png_write_png(png, info, PNG_TRANSFORM_IDENTITY, nullptr);
-  png_write_end(png, nullptr);
+  // Save the original image data
+  this->keepOriginal();
 
   // Cleanup
-  png_destroy_write_struct(&png, &info);
+  png_destroy_read_struct(&png, &info, nullptr);
+
+  this->loaded = true;
+}
+
+// @brief: Progressive reader callback for the image header
+void Image::onProgressiveInfo(png_structp png, png_infop info) {
+  Image* image = static_cast<Image*>(png_get_progressive_ptr(png));
+  LoadProgress* progress = static_cast<LoadProgress*>(png_get_error_ptr(png));
+  image->setTransforms(png, info);
+  if (!image->fitsBudget(image->getRowBytes() * image->height * 3)) png_error(png, "Over the memory budget");
+
+  // Start from a transparent frame and count the rows of every pass
+  image->data.assign(image->getRowBytes() * image->height, 0);
+  int total = 0;
+  for (int pass = 0; pass < 7; ++pass) {
+    if (PNG_PASS_COLS(image->width, pass) > 0) total += PNG_PASS_ROWS(image->height, pass);
+  }
+  progress->rows = 0;
+  progress->total = total;
+}
+
+// @brief: Progressive reader callback for one row of one Adam7 pass
+// @param `row`: The pass row, holding only the pixels of this pass
+// @param `rowNumber`: The row number within the pass
+// @param `pass`: The Adam7 pass (0-6)
+void Image::onProgressiveRow(png_structp png, png_bytep row, png_uint_32 rowNumber, int pass) {
+  Image* image = static_cast<Image*>(png_get_progressive_ptr(png));
+  LoadProgress* progress = static_cast<LoadProgress*>(png_get_error_ptr(png));
+  if (!row) return;
+
+  // Each pixel of a pass covers the block that later passes refine
+  static const int blockWidth[7] = { 8, 4, 4, 2, 2, 1, 1 };
+  static const int blockHeight[7] = { 8, 8, 4, 4, 2, 2, 1 };
+  const int y = PNG_ROW_FROM_PASS_ROW(rowNumber, pass);
+  const int yEnd = std::min(image->height, y + blockHeight[pass]);
+  const int columns = PNG_PASS_COLS(image->width, pass);
+  const size_t pixelBytes = image->getRowBytes() / image->width;
+  for (int i = 0; i < columns; ++i) {
+    const int x = PNG_COL_FROM_PASS_COL(i, pass);
+    const int xEnd = std::min(image->width, x + blockWidth[pass]);
+    const png_byte* pixel = row + pixelBytes * i;
+    for (int by = y; by < yEnd; ++by) {
+      png_byte* out = &image->data[by * image->getRowBytes() + x * pixelBytes];
+      for (int bx = x; bx < xEnd; ++bx, out += pixelBytes) std::copy(pixel, pixel + pixelBytes, out);
+    }
+  }
+
+  // Report progress and publish the frame at the end of each pass
+  progress->rows++;
+  if (static_cast<int>(rowNumber) + 1 == static_cast<int>(PNG_PASS_ROWS(image->height, pass))) progress->passes++;
+  if (progress->cancel) png_error(png, "Load cancelled");
+}
+
+// @brief: Progressive reader callback for the end of the image
+void Image::onProgressiveEnd(png_structp png, png_infop info) {
+  (void)info;
+  Image* image = static_cast<Image*>(png_get_progressive_ptr(png));
+  image->progressiveDone = true;
+}
+
+// @brief: Saves an image from memory to a file
+// @param `profile`: The speed/size trade-off used to encode the image
+// @return: Whether the file was written
+bool Image::save(SaveProfile profile) {
+  ScopedTimer timer("Save");
+
+  // Filter and deflate row strips on all cores
+  // Indexed images are packed to the smallest bit depth that holds their palette
+  int bitDepth = this->bitDepth;
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE) {
+    const size_t count = this->palette.size();
+    bitDepth = count <= 2 ? 1 : count <= 4 ? 2 : count <= 16 ? 4 : 8;
+  }
+  Encoder encoder(this->width, this->height, bitDepth, this->colorType);
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE) encoder.setPalette(this->palette, this->trans);
+  encoder.setProfile(profile);
+  return encoder.write(this->path, this->data.data());
 }
 
 // @brief: Creates an OpenGL texture from the image data
@@ -181,7 +468,7 @@ void Image::createOpenGLTexture(void) {
   }
 
   // Set the texture parameters
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->width, this->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, this->data.data());
+  this->uploadOpenGLTexture();
   if (glGetError() != GL_NO_ERROR) {
     std::cerr << "Failed to set OpenGL texture data" << std::endl;
     exit(1);
@@ -202,146 +489,371 @@ void Image::updateOpenGLTexture(void) {
   }
 
   // Update the texture data
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->width, this->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, this->data.data());
+  this->uploadOpenGLTexture();
   if (glGetError() != GL_NO_ERROR) {
     std::cerr << "Failed to update OpenGL texture data" << std::endl;
     return;
   }
 }
 
+// @brief: Deallocates the OpenGL texture, e.g. while the image is in a background tab
+void Image::releaseOpenGLTexture(void) {
+  if (!this->texture) return;
+  GLuint textureID = (GLuint)(intptr_t)this->texture;
+  glDeleteTextures(1, &textureID);
+  MemoryTracker::get().remove(MemoryCategory::TEXTURE, this->textureBytes);
+  this->textureBytes = 0;
+  this->texture = nullptr;
+}
+
+// @brief: Uploads the image data to the bound texture
+// RGB and RGBA are uploaded as they are; gray and indexed layouts are expanded to RGBA a band of rows at a time
+void Image::uploadOpenGLTexture(void) {
+  ScopedTimer timer("Texture upload");
+  const GLenum type = this->bitDepth == 16 ? GL_UNSIGNED_SHORT : GL_UNSIGNED_BYTE;
+  const int channels = this->getChannels();
+  MemoryTracker::get().remove(MemoryCategory::TEXTURE, this->textureBytes);
+  this->textureBytes = static_cast<size_t>(this->width) * this->height * 4 * (this->bitDepth / 8);
+  MemoryTracker::get().add(MemoryCategory::TEXTURE, this->textureBytes);
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1); // Rows of RGB and gray images are not 4-byte aligned
+  if (channels >= 3) {
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->width, this->height, 0, channels == 3 ? GL_RGB : GL_RGBA, type, this->data.data());
+    return;
+  }
+
+  const int bandRows = 64;
+  PixelBuffer band(static_cast<size_t>(this->width) * bandRows * 4 * (this->bitDepth / 8));
+  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, this->width, this->height, 0, GL_RGBA, type, nullptr);
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE) {
+    for (int y = 0; y < this->height; y += bandRows) {
+      int rows = std::min(bandRows, this->height - y);
+      expandIndices(&this->data[static_cast<size_t>(y) * this->width], band.data(), 4, static_cast<size_t>(this->width) * rows,
+                    this->palette.data(), static_cast<int>(this->palette.size()), this->trans.data(), static_cast<int>(this->trans.size()));
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, this->width, rows, GL_RGBA, type, band.data());
+    }
+    return;
+  }
+  withSamples(this->data, this->bitDepth, [&](auto* src) {
+    using T = std::remove_pointer_t<decltype(src)>;
+    for (int y = 0; y < this->height; y += bandRows) {
+      int rows = std::min(bandRows, this->height - y);
+      convertPixels(src + static_cast<size_t>(y) * this->width * channels, channels, reinterpret_cast<T*>(band.data()), 4, static_cast<size_t>(this->width) * rows);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, this->width, rows, GL_RGBA, type, band.data());
+    }
+  });
+}
+
+// @brief: Converts the image to a layout with at least the given channels
+// Gray becomes RGB when color is needed, and an opaque alpha channel is added when alpha is needed.
+// Indexed images are already color and only leave the palette when alpha is needed.
+// @param `color`: Whether the image needs color channels
+// @param `alpha`: Whether the image needs an alpha channel
+void Image::expand(bool color, bool alpha) {
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE) {
+    if (!alpha) return;
+    this->expandPalette();
+  }
+
+  int newColorType = this->colorType;
+  if (color) newColorType |= PNG_COLOR_MASK_COLOR;
+  if (alpha) newColorType |= PNG_COLOR_MASK_ALPHA;
+  if (newColorType == this->colorType) return;
+
+  const int channels = this->getChannels();
+  PixelBuffer tmp = std::move(this->data);
+  this->colorType = newColorType;
+  this->data.resize(this->getRowBytes() * this->height);
+  withSamples(tmp, this->bitDepth, [&](auto* src) {
+    using T = std::remove_pointer_t<decltype(src)>;
+    convertPixels(src, channels, reinterpret_cast<T*>(this->data.data()), this->getChannels(), static_cast<size_t>(this->width) * this->height);
+  });
+}
+
+// @brief: Replaces the palette indices with their RGB values, or RGBA if the palette has alpha
+void Image::expandPalette(void) {
+  if (this->colorType != PNG_COLOR_TYPE_PALETTE) return;
+
+  PixelBuffer indices = std::move(this->data);
+  this->colorType = this->trans.empty() ? PNG_COLOR_TYPE_RGB : PNG_COLOR_TYPE_RGBA;
+  this->data.resize(this->getRowBytes() * this->height);
+  expandIndices(indices.data(), this->data.data(), this->getChannels(), indices.size(),
+                this->palette.data(), static_cast<int>(this->palette.size()), this->trans.data(), static_cast<int>(this->trans.size()));
+  this->palette.clear();
+  this->trans.clear();
+}
+
 // @brief: Applies a kernel to the image
+// Kernels mix neighbouring pixels, so indexed images are expanded first
 // @param `kernel`: The kernel to apply
-void Image::applyKernel(const float kernel[][3]) {
-  std::vector<png_byte> tmp = this->data;
+void Image::applyKernel(const FilterKernel& kernel) {
+  this->expandPalette();
+  PixelBuffer tmp(this->data, MemoryCategory::SCRATCH);
 
   // Default kernel size is 3x3
-  // The average of the kernel should be 1 to maintain the same brightness
+  // The taps should sum to the divisor to maintain the same brightness
   // TODO: Allow for different kernel sizes
-  for (int y = 0; y < this->height - 2; ++y) {
-    for (int x = 0; x < this->width - 2; ++x) {
-      int idx = 4 * ((y + 1) * this->width + (x + 1)); // 4 channels (RGBA)
-
-      // Apply the kernel
-      float red_avg = 0, green_avg = 0, blue_avg = 0;
-      for (int ky = 0; ky < 3; ++ky) {
-        for (int kx = 0; kx < 3; ++kx) {
-          int kidx = 4 * ((y + ky) * this->width + (x + kx)); // 4 channels (RGBA)
-          red_avg += static_cast<float>(tmp[kidx + 0]) * kernel[ky][kx] / 9; // R
-          green_avg += static_cast<float>(tmp[kidx + 1]) * kernel[ky][kx] / 9; // G
-          blue_avg += static_cast<float>(tmp[kidx + 2]) * kernel[ky][kx] / 9; // B
-        }
-      }
-
-      // Clamp the values to 0-255
-      if (red_avg < 0) red_avg = 0;
-      if (red_avg > 255) red_avg = 255;
-      if (green_avg < 0) green_avg = 0;
-      if (green_avg > 255) green_avg = 255;
-      if (blue_avg < 0) blue_avg = 0;
-      if (blue_avg > 255) blue_avg = 255;
-
-      // Set the new pixel values
-      this->data[idx + 0] = static_cast<png_byte>(red_avg); // R
-      this->data[idx + 1] = static_cast<png_byte>(green_avg); // G
-      this->data[idx + 2] = static_cast<png_byte>(blue_avg); // B
+  withSamples(tmp, this->bitDepth, [&](auto* src) {
+    using T = std::remove_pointer_t<decltype(src)>;
+    T* dst = reinterpret_cast<T*>(this->data.data());
+    const size_t stride = static_cast<size_t>(this->width) * this->getChannels();
+    for (int y = 1; y < this->height - 1; ++y) {
+      kernelRow(src + (y - 1) * stride, src + y * stride, src + (y + 1) * stride, dst + y * stride, this->width, this->getChannels(), kernel);
     }
-  }
+  });
 }
 
 // @brief: Resets the image to its original state
 void Image::reset(void) {
   this->data = this->originalData;
+  this->colorType = this->originalColorType;
+  this->palette = this->originalPalette;
+  this->trans = this->originalTrans;
+}
+
+// @brief: Runs the pipeline on the original image
+// No-op nodes are skipped, and the run starts from the output of the last node that is still cached,
+// so changing a late node does not redo the earlier ones.
+void Image::apply(void) {
+  // Every node may need a scratch copy of the image with alpha added, in floats for Gaussian blurs
+  const bool gaussian = this->pipeline.hasActive(OperationType::GAUSSIAN) || this->pipeline.hasActive(OperationType::UNSHARP);
+  const size_t sampleBytes = gaussian ? sizeof(float) : this->bitDepth / 8;
+  if (!this->fitsBudget(static_cast<size_t>(this->width) * this->height * 4 * sampleBytes)) return;
+
+  // Nodes work on the whole image and do not report what they changed, so the histogram is counted
+  // again in full on the next read; only undo and redo, which know their tiles, update it in place.
+  this->histogramValid = false;
+  std::vector<size_t> active;
+  std::vector<uint64_t> hashes = this->pipeline.getHashes(active);
+
+  // Start from the latest cached output, or the original
+  PipelineOutput output;
+  output.data = PixelBuffer(MemoryCategory::IMAGE);
+  size_t first = hashes.size();
+  while (first > 0 && !this->pipeline.lookup(hashes[first - 1], output)) --first;
+  if (first > 0) {
+    this->colorType = output.colorType;
+    this->palette = std::move(output.palette);
+    this->trans = std::move(output.trans);
+    this->data = std::move(output.data);
+  } else {
+    this->reset();
+  }
+
+  // Run the remaining nodes and cache their outputs
+  for (size_t k = first; k < active.size(); ++k) {
+    this->run(this->pipeline.getOperations()[active[k]]);
+    this->pipeline.store(hashes[k], this->colorType, this->palette, this->trans, this->data);
+  }
+}
+
+// @brief: Deallocates the edited pixels and the cached node outputs, which restoreData computes again
+// The original, the history and the pipeline stay, so nothing is lost
+void Image::releaseData(void) {
+  this->data = PixelBuffer(MemoryCategory::IMAGE);
+  this->pipeline.clearCache();
+}
+
+// @brief: Computes the edited pixels again after releaseData
+// When the image is in its last committed state (the same operations, layout and palette) they are a copy
+// of the last commit; otherwise the pipeline runs again
+// @return: Whether the image has its edited pixels
+bool Image::restoreData(void) {
+  if (!this->loaded || this->isResident()) return true;
+  if (this->getState() == this->committedState) {
+    if (!this->fitsBudget(this->committedData.size())) return false;
+    this->data = this->committedData;
+    return true;
+  }
+  this->apply();
+  return this->isResident();
+}
+
+// @brief: Runs a single operation on the image
+// @param `operation`: The operation and its parameters
+void Image::run(const Operation& operation) {
+  ScopedTimer timer(operation.getName());
+  switch (operation.type) {
+    case OperationType::INVERT: this->invert(); break;
+    case OperationType::GRAYSCALE: this->grayscale(); break;
+    case OperationType::BLUR: this->blur(); break;
+    case OperationType::SHARPEN: this->sharpen(); break;
+    case OperationType::UNSHARP: this->unsharp(operation.radius, operation.amount, operation.threshold); break;
+    case OperationType::RGB: this->rgb(operation.red, operation.green, operation.blue); break;
+    case OperationType::ROTATE: this->rotate(operation.angle); break;
+    case OperationType::GAUSSIAN: this->gaussian(operation.sigma); break;
+    case OperationType::MEDIAN: this->median(operation.medianRadius); break;
+    case OperationType::BILATERAL: this->bilateral(operation.spatial, operation.range); break;
+  }
 }
 
 // @brief: Inverts the colors of the image
 void Image::invert(void) {
-  for (int y = 0; y < this->height; ++y) {
-    for (int x = 0; x < this->width; ++x) {
-      int idx = 4 * (y * this->width + x); // 4 channels (RGBA)
-      this->data[idx + 0] = 255 - this->data[idx + 0]; // R
-      this->data[idx + 1] = 255 - this->data[idx + 1]; // G
-      this->data[idx + 2] = 255 - this->data[idx + 2]; // B
-    }
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE) {
+    invertPalette(this->palette.data(), static_cast<int>(this->palette.size()));
+    return;
   }
+  withSamples(this->data, this->bitDepth, [&](auto* samples) { invertRow(samples, this->width * this->height, this->getChannels()); });
 }
 
 // @brief: Grayscales the image
 void Image::grayscale(void) {
-  for (int y = 0; y < this->height; ++y) {
-    for (int x = 0; x < this->width; ++x) {
-      int idx = 4 * (y * this->width + x); // 4 channels (RGBA)
-      png_byte avg = static_cast<png_byte>((this->data[idx + 0] + this->data[idx + 1] + this->data[idx + 2]) / 3);
-      this->data[idx + 0] = avg; // R
-      this->data[idx + 1] = avg; // G
-      this->data[idx + 2] = avg; // B
-    }
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE) {
+    grayscalePalette(this->palette.data(), static_cast<int>(this->palette.size()));
+    return;
   }
+  withSamples(this->data, this->bitDepth, [&](auto* samples) { grayscaleRow(samples, this->width * this->height, this->getChannels()); });
 }
 
 // @brief: Blurs the image
 void Image::blur(void) {
-  const float kernel[3][3] = {
-    { 1, 1, 1 },
-    { 1, 1, 1 },
-    { 1, 1, 1 }
-  };
-  this->applyKernel(kernel);
+  this->applyKernel(BLUR_KERNEL);
 }
 
 // @brief: Sharpens the image
 void Image::sharpen(void) {
-  const float kernel[3][3] = {
-    { -1, -1, -1 },
-    { -1, 17, -1 },
-    { -1, -1, -1 }
-  };
-  this->applyKernel(kernel);
+  this->applyKernel(SHARPEN_KERNEL);
 }
 
-// @brief: Sets the image's RGB values to the given values
-void Image::rgb(void) {
-  for (int y = 0; y < this->height; ++y) {
-    for (int x = 0; x < this->width; ++x) {
-      int idx = 4 * (y * this->width + x); // 4 channels (RGBA)
-      this->data[idx + 0] = static_cast<png_byte>(this->data[idx + 0] * red); // R
-      this->data[idx + 1] = static_cast<png_byte>(this->data[idx + 1] * green); // G
-      this->data[idx + 2] = static_cast<png_byte>(this->data[idx + 2] * blue); // B
-    }
+// @brief: Sharpens the image with an unsharp mask
+// Sharpening mixes neighbouring pixels, so indexed images are expanded first
+// @param `radius`: The blur of the mask in pixels
+// @param `amount`: The strength of the mask
+// @param `threshold`: The smallest difference that is sharpened, in 8-bit levels
+void Image::unsharp(float radius, float amount, float threshold) {
+  this->expandPalette();
+  withSamples(this->data, this->bitDepth, [&](auto* samples) {
+    unsharpPixels(samples, samples, this->width, this->height, this->getChannels(), radius, amount, threshold);
+  });
+}
+
+// @brief: Scales the image's RGB values by the given gains
+// Gray images only become RGB when the gains differ
+// @param `red`, `green`, `blue`: The gain of each channel
+void Image::rgb(float red, float green, float blue) {
+  if (red == 1.0f && green == 1.0f && blue == 1.0f) return;
+  if (this->colorType == PNG_COLOR_TYPE_PALETTE) {
+    rgbPalette(this->palette.data(), static_cast<int>(this->palette.size()), red, green, blue);
+    return;
   }
+  if (red != green || green != blue) this->expand(true, false);
+  withSamples(this->data, this->bitDepth, [&](auto* samples) { rgbRow(samples, this->width * this->height, this->getChannels(), red, green, blue); });
 }
 
 // @brief: Rotates the image
-void Image::rotate(void) {
-  std::vector<png_byte> tmpData = this->data;
+// Images without alpha gain an alpha channel so that the uncovered corners stay transparent
+// @param `angle`: The angle in degrees
+void Image::rotate(int angle) {
+  if (angle % 360 == 0) return;
+  this->expand(false, true);
+  PixelBuffer tmpData(this->data, MemoryCategory::SCRATCH);
+  withSamples(tmpData, this->bitDepth, [&](auto* src) {
+    using T = std::remove_pointer_t<decltype(src)>;
+    rotatePixels(src, reinterpret_cast<T*>(this->data.data()), this->width, this->height, this->getChannels(), angle);
+  });
+}
 
-  // Clear the image
-  for (int y = 0; y < this->height; ++y) {
-    for (int x = 0; x < this->width; ++x) {
-      int idx = 4 * (y * this->width + x); // 4 channels (RGBA)
-      this->data[idx + 0] = 0; // R
-      this->data[idx + 1] = 0; // G
-      this->data[idx + 2] = 0; // B
-      this->data[idx + 3] = 0; // A
-    }
-  }
+// @brief: Blurs the image with a Gaussian whose cost does not depend on sigma
+// Blurs mix neighbouring pixels, so indexed images are expanded first
+// @param `sigma`: The standard deviation in pixels
+void Image::gaussian(float sigma) {
+  this->expandPalette();
+  withSamples(this->data, this->bitDepth, [&](auto* samples) { gaussianPixels(samples, samples, this->width, this->height, this->getChannels(), sigma); });
+}
 
-  // Rotate the image
-  for (int y = 0; y < this->height; ++y) {
-    for (int x = 0; x < this->width; ++x) {
-      // [[cos(theta), -sin(theta)], [sin(theta), cos(theta)]] * [x, y]
-      float rad = this->rotateAngle * M_PI / 180.0f;
-      int ny = static_cast<int>(std::round((x - this->width / 2.0f) * std::sin(rad) + (y - this->height / 2.0f) * std::cos(rad) + this->height / 2.0f));
-      int nx = static_cast<int>(std::round((x - this->width / 2.0f) * std::cos(rad) - (y - this->height / 2.0f) * std::sin(rad) + this->width / 2.0f));
-      if (ny < 0 || ny >= this->height || nx < 0 || nx >= this->width) continue;
-
-      int idx = 4 * (y * this->width + x); // 4 channels (RGBA)
-      int kidx = 4 * (ny * this->width + nx); // 4 channels (RGBA)
-      this->data[idx + 0] = tmpData[kidx + 0]; // R
-      this->data[idx + 1] = tmpData[kidx + 1]; // G
-      this->data[idx + 2] = tmpData[kidx + 2]; // B
-      this->data[idx + 3] = tmpData[kidx + 3]; // A
-    }
-  }
+// @brief: Replaces every pixel with the median of its neighbourhood, which removes salt-and-pepper noise
+// Medians mix neighbouring pixels, so indexed images are expanded first
+// @param `radius`: The radius of the window in pixels
+void Image::median(int radius) {
+  this->expandPalette();
+  PixelBuffer tmp(this->data, MemoryCategory::SCRATCH);
+  withSamples(tmp, this->bitDepth, [&](auto* src) {
+    using T = std::remove_pointer_t<decltype(src)>;
+    medianPixels(src, reinterpret_cast<T*>(this->data.data()), this->width, this->height, this->getChannels(), radius);
+  });
+}
+
+// @brief: Smooths the image without blurring across edges
+// Smoothing mixes neighbouring pixels, so indexed images are expanded first
+// @param `spatial`: The spatial sigma in pixels
+// @param `range`: The range sigma in 8-bit levels
+void Image::bilateral(float spatial, float range) {
+  this->expandPalette();
+  PixelBuffer tmp(this->data, MemoryCategory::SCRATCH);
+  withSamples(tmp, this->bitDepth, [&](auto* src) {
+    using T = std::remove_pointer_t<decltype(src)>;
+    bilateralPixels(src, reinterpret_cast<T*>(this->data.data()), this->width, this->height, this->getChannels(), spatial, range);
+  });
+}
+
+// @brief: Resamples the edited image to a new size
+// The size is not part of the pipeline, so the edits are baked into the resized image, which becomes the
+// new original with an empty pipeline and history. Resampling mixes neighbouring pixels, so indexed images
+// are expanded first
+// @param `width`, `height`: The new size in pixels
+// @param `filter`: The resampling filter
+void Image::resize(int width, int height, ResizeFilter filter) {
+  ScopedTimer timer("Resize");
+  if (width <= 0 || height <= 0 || (width == this->width && height == this->height)) return;
+  this->expandPalette();
+
+  // The old buffers are needed while resampling, and give way to three of the new size after it
+  const size_t bytes = static_cast<size_t>(width) * height * this->getChannels() * (this->bitDepth / 8);
+  const size_t held = this->data.size() + this->originalData.size() + this->committedData.size();
+  if (!this->fitsBudget(std::max(bytes, 3 * bytes > held ? 3 * bytes - held : 0))) return;
+
+  PixelBuffer resized(MemoryCategory::IMAGE);
+  resized.resize(bytes);
+  withSamples(this->data, this->bitDepth, [&](auto* src) {
+    using T = std::remove_pointer_t<decltype(src)>;
+    resizePixels(src, this->width, this->height, reinterpret_cast<T*>(resized.data()), width, height, this->getChannels(), filter);
+  });
+  this->data = std::move(resized);
+  this->width = width;
+  this->height = height;
+
+  this->originalData.clear();
+  this->originalData.shrink_to_fit();
+  this->committedData.clear();
+  this->committedData.shrink_to_fit();
+  this->pipeline.clear();
+  this->keepOriginal();
+}
+
+// @brief: Records the changes since the last commit as one undoable edit
+// Called once an edit is finished, so that dragging a slider makes a single entry
+void Image::commit(void) {
+  HistoryState state = this->getState();
+  this->history.record(this->committedState, this->committedData, state, this->data, this->width, this->height);
+  this->committedData = this->data;
+  this->committedState = state;
+}
+
+// @brief: Undoes the last edit
+// @return: Whether there was an edit to undo
+bool Image::undo(void) {
+  this->commit();
+  HistoryState before = this->committedState;
+  std::vector<HistoryRegion> regions;
+  if (!this->history.undo(this->committedState, this->committedData, &regions)) return false;
+  this->updateHistogram(before, regions);
+  this->copyCommittedRegions(before, regions, true);
+  this->setState(this->committedState);
+  return true;
+}
+
+// @brief: Redoes the last undone edit
+// @return: Whether there was an edit to redo
+bool Image::redo(void) {
+  // Uncommitted edits are dropped, so neither the histogram nor the pixel data match the committed data
+  const bool edited = this->pipeline.getOperations() != this->committedState.operations;
+  if (edited) this->histogramValid = false;
+  HistoryState before = this->committedState;
+  std::vector<HistoryRegion> regions;
+  if (!this->history.redo(this->committedState, this->committedData, &regions)) return false;
+  this->updateHistogram(before, regions);
+  this->copyCommittedRegions(before, regions, !edited);
+  this->setState(this->committedState);
+  return true;
 }
 
 /////////////////// IMAGE GETTERS ///////////////////
@@ -352,12 +864,33 @@ int Image::getWidth(void) const { return this->width; }
 int Image::getHeight(void) const { return this->height; }
 int Image::getBitDepth(void) const { return this->bitDepth; }
 int Image::getColorType(void) const { return this->colorType; }
-std::vector<png_byte> Image::getData(void) const { return this->data; }
+int Image::getChannels(void) const {
+  switch (this->colorType) {
+    case PNG_COLOR_TYPE_GRAY_ALPHA: return 2;
+    case PNG_COLOR_TYPE_RGB: return 3;
+    case PNG_COLOR_TYPE_RGBA: return 4;
+    default: return 1; // Gray and palette indices
+  }
+}
+size_t Image::getRowBytes(void) const { return static_cast<size_t>(this->width) * this->getChannels() * (this->bitDepth / 8); }
+PixelBuffer Image::getData(void) const { return this->data; }
 ImTextureID Image::getTexture(void) const { return this->texture; }
-bool Image::isInvert(void) const { return this->_invert; }
-bool Image::isGrayscale(void) const { return this->_grayscale; }
-bool Image::isBlur(void) const { return this->_blur; }
-bool Image::isSharpen(void) const { return this->_sharpen; }
+bool Image::isOverBudget(void) const { return this->overBudget; }
+bool Image::isResident(void) const { return !this->data.empty(); }
+size_t Image::getResidentBytes(void) const { return this->data.size() + this->pipeline.getCacheBytes(); }
+bool Image::canUndo(void) const { return this->history.canUndo() || this->pipeline.getOperations() != this->committedState.operations; }
+bool Image::canRedo(void) const { return this->history.canRedo(); }
+History& Image::getHistory(void) { return this->history; }
+const Histogram& Image::getHistogram(void) {
+  if (!this->histogramValid) {
+    ScopedTimer timer("Histogram");
+    this->histogram.compute(this->getHistogramSource(this->data, this->getState()));
+    this->histogramValid = true;
+  }
+  return this->histogram;
+}
+Pipeline& Image::getPipeline(void) { return this->pipeline; }
+const Pipeline& Image::getPipeline(void) const { return this->pipeline; }
 
 /////////////////// IMAGE SETTERS ///////////////////
 
@@ -367,9 +900,9 @@ void Image::setWidth(int width) { this->width = width; }
 void Image::setHeight(int height) { this->height = height; }
 void Image::setBitDepth(int bitDepth) { this->bitDepth = bitDepth; }
 void Image::setColorType(int colorType) { this->colorType = colorType; }
-void Image::setData(std::vector<png_byte> data) { this->data = data; }
+void Image::setData(PixelBuffer data) {
+  this->data = data;
+  this->histogramValid = false;
+}
 void Image::setTexture(ImTextureID texture) { this->texture = texture; }
-void Image::setInvert(bool invert) { this->_invert = invert; }
-void Image::setGrayscale(bool grayscale) { this->_grayscale = grayscale; }
-void Image::setBlur(bool blur) { this->_blur = blur; }
-void Image::setSharpen(bool sharpen) { this->_sharpen = sharpen; }
\ No newline at end of file
+void Image::setCacheDecoded(bool cacheDecoded) { this->cacheDecoded = cacheDecoded; }
\ No newline at end of file
@@ -2,8 +2,31 @@
 
 #include <string>
 #include <vector>
+#include <atomic>
+#include <mutex>
 #include <png.h>
 #include <imgui.h>
+#include "history.h"
+#include "histogram.h"
+#include "filters.h"
+#include "resize.h"
+
+/* Save Profiles */
+enum class SaveProfile {
+  FASTEST,  // zlib level 1, RLE strategy, Sub filter only
+  BALANCED, // zlib level 6, filtered strategy, adaptive filters
+  SMALLEST  // zlib level 9, filtered strategy, adaptive filters
+};
+
+/* Load Progress */
+// Shared between a loading thread and the UI thread
+struct LoadProgress {
+  std::atomic<int> rows{ 0 };      // Rows decoded so far, over all passes
+  std::atomic<int> total{ 0 };     // Rows to decode, over all passes
+  std::atomic<bool> cancel{ false }; // Set to abort the load
+  std::atomic<int> passes{ 0 };    // Adam7 passes finished, for progressive loads
+  std::mutex lock;                 // Held while the loader writes pixel data
+};
 
 class Image {
 private:
@@ -14,21 +37,45 @@ private:
   int height;
   int bitDepth;
   int colorType;
-  std::vector<png_byte> originalData;
-  std::vector<png_byte> data;
+  int originalColorType;
+  PixelBuffer originalData;
+  PixelBuffer data;
+  std::vector<png_color> originalPalette;
+  std::vector<png_color> palette; // PLTE entries of indexed images
+  std::vector<png_byte> originalTrans;
+  std::vector<png_byte> trans;    // tRNS alpha of every PLTE entry, empty if opaque
   ImTextureID texture;
-  bool _invert;
-  bool _grayscale;
-  bool _blur;
-  bool _sharpen;
+  size_t textureBytes;
+  History history;
+  PixelBuffer committedData; // The image as of the last commit, the base of the next history entry
+  HistoryState committedState;
+  Pipeline pipeline;
+  Histogram histogram;
+  bool histogramValid; // Whether the histogram counts the current pixel data
+  bool progressiveDone;
+  bool overBudget; // Whether the last load or apply stopped at the memory budget
+  bool cacheDecoded; // Whether loads keep a copy of the decoded file in the decode cache
 
-public:
-  /* Public Variables */
-  float red;
-  float green;
-  float blue;
-  int rotateAngle;
+  /* Private Methods */
+  void setTransforms(png_structp png, png_infop info);
+  void keepOriginal(void);
+  bool fitsBudget(size_t bytes);
+  bool loadDecoded(const std::string& key);
+  void storeDecoded(const std::string& key) const;
+  HistoryState getState(void) const;
+  void setState(const HistoryState& state);
+  HistogramSource getHistogramSource(const PixelBuffer& data, const HistoryState& state) const;
+  void updateHistogram(const HistoryState& before, const std::vector<HistoryRegion>& regions);
+  void copyCommittedRegions(const HistoryState& before, const std::vector<HistoryRegion>& regions, bool matched);
+  void uploadOpenGLTexture(void);
+  void expand(bool color, bool alpha);
+  void expandPalette(void);
+  void loadProgressive(const png_byte* file, size_t size, LoadProgress* progress);
+  static void onProgressiveInfo(png_structp png, png_infop info);
+  static void onProgressiveRow(png_structp png, png_bytep row, png_uint_32 rowNumber, int pass);
+  static void onProgressiveEnd(png_structp png, png_infop info);
 
+public:
   /* Constructor */
   Image(void);
 
@@ -36,18 +83,31 @@ public:
   ~Image(void);
 
   /* Methods */
-  void load(const std::string path);
-  void save(void);
+  void load(const std::string path, LoadProgress* progress = nullptr);
+  bool save(SaveProfile profile = SaveProfile::BALANCED);
   void createOpenGLTexture(void);
   void updateOpenGLTexture(void);
-  void applyKernel(const float kernel[][3]);
+  void releaseOpenGLTexture(void);
+  void releaseData(void);
+  bool restoreData(void);
+  void applyKernel(const FilterKernel& kernel);
   void reset(void);
+  void apply(void);
   void invert(void);
   void grayscale(void);
   void blur(void);
   void sharpen(void);
-  void rgb(void);
-  void rotate(void);
+  void unsharp(float radius, float amount, float threshold);
+  void rgb(float red, float green, float blue);
+  void rotate(int angle);
+  void gaussian(float sigma);
+  void median(int radius);
+  void bilateral(float spatial, float range);
+  void resize(int width, int height, ResizeFilter filter);
+  void run(const Operation& operation);
+  void commit(void);
+  bool undo(void);
+  bool redo(void);
 
   /* Getters */
   std::string getPath(void) const;
@@ -56,12 +116,19 @@ public:
   int getHeight(void) const;
   int getBitDepth(void) const;
   int getColorType(void) const;
-  std::vector<png_byte> getData(void) const;
+  int getChannels(void) const;
+  size_t getRowBytes(void) const;
+  PixelBuffer getData(void) const;
   ImTextureID getTexture(void) const;
-  bool isInvert(void) const;
-  bool isGrayscale(void) const;
-  bool isBlur(void) const;
-  bool isSharpen(void) const;
+  bool isOverBudget(void) const;
+  bool isResident(void) const;
+  size_t getResidentBytes(void) const;
+  Pipeline& getPipeline(void);
+  const Pipeline& getPipeline(void) const;
+  bool canUndo(void) const;
+  bool canRedo(void) const;
+  History& getHistory(void);
+  const Histogram& getHistogram(void);
 
   /* Setters */
   void setPath(std::string path);
@@ -70,10 +137,7 @@ public:
   void setHeight(int height);
   void setBitDepth(int bitDepth);
   void setColorType(int colorType);
-  void setData(std::vector<png_byte> data);
+  void setData(PixelBuffer data);
   void setTexture(ImTextureID texture);
-  void setInvert(bool invert);
-  void setGrayscale(bool grayscale);
-  void setBlur(bool blur);
-  void setSharpen(bool sharpen);
+  void setCacheDecoded(bool cacheDecoded);
 };
\ No newline at end of file
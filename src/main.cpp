@@ -7,12 +7,14 @@
 #include <backends/imgui_impl_opengl3.h>
 #include <png.h>
 #include "image.h"
+#include "workspace.h"
 #include "render.h"
+#include "batch.h"
+#include "profiler.h"
 
 int main(int argc, char* argv[]) {
-  // Disable stdout buffering
-  (void)argc;
-  (void)argv;
+  // Run without a window when files are given on the command line
+  if (argc > 1) return Batch::runAll(argc, argv);
 
   // Initialize GLFW
   if (!glfwInit()) {
@@ -74,46 +76,61 @@ int main(int argc, char* argv[]) {
 
   // Our state
   ImVec4 clearColor = ImVec4(0.45f, 0.55f, 0.60f, 1.00f); // Default background color
-  std::unique_ptr<Image> image = std::make_unique<Image>();
+  std::unique_ptr<Workspace> workspace = std::make_unique<Workspace>();
   std::unique_ptr<Renderer> renderer = std::make_unique<Renderer>();
 
   // Main loop
   while (!glfwWindowShouldClose(window)) {
-    // Wait for events (inputs, window resize, etc.)
-    glfwWaitEvents();
+    // Wait for events (inputs, window resize, etc.), and keep redrawing while loading
+    if (renderer->isLoading()) glfwWaitEventsTimeout(1.0 / 30.0);
+    else glfwWaitEvents();
+
+    // Time the frame from the first event through the buffer swap, without the idle wait
+    ScopedTimer frameTimer("Frame");
 
     // Start the Dear ImGui frame
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplGlfw_NewFrame();
     ImGui::NewFrame();
 
-    // Render the main menu
-    renderer->renderMainMenu(window, io, image);
+    // Render the main menu, for the document in the active tab
+    renderer->renderMainMenu(window, io, workspace->getActive());
 
-    // Render the file dialog
-    renderer->renderFileDialog(window, image);
+    // Render the file dialog, which opens files in new tabs
+    renderer->renderFileDialog(window, *workspace);
 
     // Render the control panel
-    if (image->isLoaded()) renderer->renderControlPanel(window, image);
+    std::unique_ptr<Image>& image = workspace->getActive();
+    if (image->isLoaded() && image->isResident()) renderer->renderControlPanel(window, image);
 
     // Create an OpenGL texture from the image data
-    if (image->isLoaded() && !image->getTexture()) image->createOpenGLTexture();
+    if (image->isLoaded() && image->isResident() && !image->getTexture()) image->createOpenGLTexture();
+
+    // Render the image editor window with its tabs, which may change the active document
+    renderer->renderImageEditorWindow(window, *workspace);
+
+    // Release what background tabs hold
+    workspace->trim();
 
-    // Render the image editor window
-    if (image->isLoaded()) renderer->renderImageEditorWindow(window, image);
+    // Render the timings and memory windows
+    renderer->renderTimingsWindow();
+    renderer->renderMemoryWindow();
 
     // Rendering
     glViewport(0, 0, (int)io.DisplaySize.x, (int)io.DisplaySize.y);
     glClearColor(clearColor.x, clearColor.y, clearColor.z, clearColor.w);
     glClear(GL_COLOR_BUFFER_BIT);
-    ImGui::Render();
-    ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    {
+      ScopedTimer renderTimer("ImGui render");
+      ImGui::Render();
+      ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
+    }
     glfwSwapBuffers(window);
   }
 
   // Cleanup
-  image.release();
-  renderer.release();
+  workspace.reset();
+  renderer.reset();
   ImGui_ImplOpenGL3_Shutdown();
   ImGui_ImplGlfw_Shutdown();
   ImGui::DestroyContext();
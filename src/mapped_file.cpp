@@ -0,0 +1,106 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include "mapped_file.h"
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+/////////////////// MAPPED FILE CONSTRUCTOR ///////////////////
+
+// @brief: Initializes an empty mapping
+MappedFile::MappedFile(void) {
+  this->data = nullptr;
+  this->size = 0;
+  this->offset = 0;
+  this->mapped = false;
+}
+
+/////////////////// MAPPED FILE DESTRUCTOR ////////////////////
+
+// @brief: Unmaps the file
+MappedFile::~MappedFile(void) {
+  this->close();
+}
+
+/////////////////// MAPPED FILE METHODS ///////////////////////
+
+// @brief: Maps a file into memory for reading
+// Falls back to reading the file into a buffer when it cannot be mapped
+// @param `path`: The path to the file
+bool MappedFile::open(const std::string path) {
+  this->close();
+
+#ifndef _WIN32
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    std::cerr << "Failed to open for reading: " << path << std::endl;
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) == 0 && st.st_size > 0) {
+    void* address = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    if (address != MAP_FAILED) {
+      // The decoder reads the file front to back exactly once
+      madvise(address, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+      this->data = static_cast<const png_byte*>(address);
+      this->size = static_cast<size_t>(st.st_size);
+      this->mapped = true;
+    }
+  }
+  ::close(fd);
+  if (this->mapped) return true;
+#endif
+
+  // Read the whole file instead
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    std::cerr << "Failed to open for reading: " << path << std::endl;
+    return false;
+  }
+  this->buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  this->data = this->buffer.data();
+  this->size = this->buffer.size();
+  return true;
+}
+
+// @brief: Unmaps the file and releases the fallback buffer
+void MappedFile::close(void) {
+#ifndef _WIN32
+  if (this->mapped) munmap(const_cast<png_byte*>(this->data), this->size);
+#endif
+  this->buffer.clear();
+  this->buffer.shrink_to_fit();
+  this->data = nullptr;
+  this->size = 0;
+  this->offset = 0;
+  this->mapped = false;
+}
+
+// @brief: Makes libpng read from the start of the mapping
+// @param `png`: The PNG read struct
+void MappedFile::attach(png_structp png) {
+  this->offset = 0;
+  png_set_read_fn(png, this, MappedFile::read);
+}
+
+// @brief: libpng read callback that copies straight from the mapping
+// @param `png`: The PNG read struct whose io pointer is the mapped file
+// @param `out`: The destination buffer
+// @param `length`: The number of bytes to read
+void MappedFile::read(png_structp png, png_bytep out, png_size_t length) {
+  MappedFile* file = static_cast<MappedFile*>(png_get_io_ptr(png));
+  if (length > file->size - file->offset) png_error(png, "Unexpected end of file");
+  std::memcpy(out, file->data + file->offset, length);
+  file->offset += length;
+}
+
+/////////////////// MAPPED FILE GETTERS ///////////////////////
+
+bool MappedFile::isOpen(void) const { return this->data != nullptr; }
+const png_byte* MappedFile::getData(void) const { return this->data; }
+size_t MappedFile::getSize(void) const { return this->size; }
+size_t MappedFile::getOffset(void) const { return this->offset; }
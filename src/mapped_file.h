@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <png.h>
+
+class MappedFile {
+private:
+  /* Private Variables */
+  const png_byte* data;
+  size_t size;
+  size_t offset;
+  bool mapped;
+  std::vector<png_byte> buffer; // Used when the file cannot be mapped
+
+public:
+  /* Constructor */
+  MappedFile(void);
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  /* Destructor */
+  ~MappedFile(void);
+
+  /* Methods */
+  bool open(const std::string path);
+  void close(void);
+  void attach(png_structp png);
+  static void read(png_structp png, png_bytep out, png_size_t length);
+
+  /* Getters */
+  bool isOpen(void) const;
+  const png_byte* getData(void) const;
+  size_t getSize(void) const;
+  size_t getOffset(void) const;
+};
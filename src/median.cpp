@@ -0,0 +1,193 @@
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include "median.h"
+#include "parallel.h"
+#include "memory_tracker.h"
+
+/////////////////// MEDIAN HELPERS //////////////////////
+
+using Counts = std::vector<uint16_t, TrackedAllocator<uint16_t>>; // A window holds at most 101^2 samples
+
+// @brief: Returns the first bin at which the running count passes `rank`
+// @param `counts`: The histogram
+// @param `bins`: The number of bins
+// @param `rank`: The number of samples to skip, reduced by the samples in the bins before the result
+static int findRank(const uint16_t* counts, int bins, int& rank) {
+  int bin = 0;
+  while (bin < bins - 1 && rank >= counts[bin]) rank -= counts[bin++];
+  return bin;
+}
+
+// @brief: Filters a band of 8-bit rows with column histograms
+// Every column keeps a histogram of the 2 * radius + 1 samples centred on the current row, which
+// moves down one sample per row. The window histogram slides right by adding the column that enters
+// and subtracting the one that leaves. Only its 16 coarse bins are updated for every pixel; the 16 fine
+// bins under a coarse bin are brought up to date when the median falls into it, which is rare enough
+// for most of them to be skipped. The fine bins of the columns are stored by coarse bin, so that
+// catching up reads neighbouring columns from the same block of memory.
+// @param `first`, `rows`: The rows of the band
+static void medianBand8(const png_byte* src, png_byte* dst, int width, int height, int channels, int radius, int first, int rows) {
+  const int bins = 256;
+  const int coarseBins = bins / MEDIAN_FINE_BINS;
+  const bool alpha = channels == 2 || channels == 4;
+  const int colors = alpha ? channels - 1 : channels;
+  const size_t rowSamples = static_cast<size_t>(width) * channels;
+  const size_t columnBins = static_cast<size_t>(colors) * bins;
+  const size_t columnCoarse = static_cast<size_t>(colors) * coarseBins;
+  const int median = (2 * radius + 1) * (2 * radius + 1) / 2;
+  Counts columns(width * columnBins);
+  Counts coarseColumns(width * columnCoarse);
+  Counts window(columnBins);
+  Counts coarseWindow(columnCoarse);
+  std::vector<int> updated(columnCoarse); // The pixel that each group of fine bins was last updated for
+
+  // Adds `delta` for row `y` to the histograms of every column
+  auto updateColumns = [&](int y, int delta) {
+    const png_byte* row = src + std::clamp(y, 0, height - 1) * rowSamples;
+    for (int x = 0; x < width; ++x) {
+      for (int c = 0; c < colors; ++c) {
+        const png_byte value = row[x * channels + c];
+        columns[((c * coarseBins + value / MEDIAN_FINE_BINS) * width + x) * MEDIAN_FINE_BINS + value % MEDIAN_FINE_BINS] += delta;
+        coarseColumns[x * columnCoarse + c * coarseBins + value / MEDIAN_FINE_BINS] += delta;
+      }
+    }
+  };
+
+  // Returns the fine bins under coarse bin `coarse` of channel `c`, brought up to date for pixel `x`
+  auto fineBins = [&](int c, int coarse, int x) {
+    uint16_t* fine = &window[c * bins + coarse * MEDIAN_FINE_BINS];
+    const uint16_t* group = &columns[(c * coarseBins + coarse) * width * MEDIAN_FINE_BINS];
+    int& last = updated[c * coarseBins + coarse];
+    if (last < 0 || x - last > 2 * radius) {
+      std::fill(fine, fine + MEDIAN_FINE_BINS, 0);
+      for (int dx = -radius; dx <= radius; ++dx) {
+        const uint16_t* column = group + std::clamp(x + dx, 0, width - 1) * MEDIAN_FINE_BINS;
+        for (int i = 0; i < MEDIAN_FINE_BINS; ++i) fine[i] += column[i];
+      }
+    } else {
+      for (int p = last + 1; p <= x; ++p) {
+        const uint16_t* enter = group + std::min(p + radius, width - 1) * MEDIAN_FINE_BINS;
+        const uint16_t* leave = group + std::max(p - radius - 1, 0) * MEDIAN_FINE_BINS;
+        for (int i = 0; i < MEDIAN_FINE_BINS; ++i) fine[i] += enter[i] - leave[i];
+      }
+    }
+    last = x;
+    return fine;
+  };
+
+  for (int y = first - radius; y <= first + radius; ++y) updateColumns(y, 1);
+  for (int y = first; y < first + rows; ++y) {
+    if (y > first) {
+      updateColumns(y - radius - 1, -1);
+      updateColumns(y + radius, 1);
+    }
+
+    // The window of the first pixel repeats the first column
+    std::fill(coarseWindow.begin(), coarseWindow.end(), 0);
+    std::fill(updated.begin(), updated.end(), -1);
+    for (int dx = -radius; dx <= radius; ++dx) {
+      const int x = std::clamp(dx, 0, width - 1);
+      for (size_t i = 0; i < columnCoarse; ++i) coarseWindow[i] += coarseColumns[x * columnCoarse + i];
+    }
+
+    for (int x = 0; x < width; ++x) {
+      if (x > 0) {
+        const uint16_t* enter = &coarseColumns[std::min(x + radius, width - 1) * columnCoarse];
+        const uint16_t* leave = &coarseColumns[std::max(x - radius - 1, 0) * columnCoarse];
+        for (size_t i = 0; i < columnCoarse; ++i) coarseWindow[i] += enter[i] - leave[i];
+      }
+
+      const size_t offset = y * rowSamples + x * channels;
+      for (int c = 0; c < colors; ++c) {
+        int rank = median;
+        const int coarse = findRank(&coarseWindow[c * coarseBins], coarseBins, rank);
+        const int fine = findRank(fineBins(c, coarse, x), MEDIAN_FINE_BINS, rank);
+        dst[offset + c] = static_cast<png_byte>(coarse * MEDIAN_FINE_BINS + fine);
+      }
+      if (alpha) dst[offset + colors] = src[offset + colors]; // Alpha is kept as is
+    }
+  }
+}
+
+// @brief: Filters a band of 16-bit rows with a window histogram that slides along each row
+// The histogram is a tree of four levels of 16 bins that split the sample range 4 bits at a time, so
+// finding the median scans 64 bins. Moving right adds and removes the 2 * radius + 1 samples of one
+// column each.
+// @param `first`, `rows`: The rows of the band
+static void medianBand16(const png_uint_16* src, png_uint_16* dst, int width, int height, int channels, int radius, int first, int rows) {
+  const int levels = 4;
+  const bool alpha = channels == 2 || channels == 4;
+  const int colors = alpha ? channels - 1 : channels;
+  const size_t rowSamples = static_cast<size_t>(width) * channels;
+  const int median = (2 * radius + 1) * (2 * radius + 1) / 2;
+  std::vector<Counts> tree;
+  for (int level = 0, bins = MEDIAN_FINE_BINS; level < levels; ++level, bins *= MEDIAN_FINE_BINS) tree.emplace_back(static_cast<size_t>(colors) * bins);
+
+  // Adds `delta` for the samples of column `x` around row `y`
+  auto updateWindow = [&](int y, int x, int delta) {
+    const png_uint_16* column = src + std::clamp(x, 0, width - 1) * channels;
+    for (int dy = -radius; dy <= radius; ++dy) {
+      const png_uint_16* pixel = column + std::clamp(y + dy, 0, height - 1) * rowSamples;
+      for (int c = 0; c < colors; ++c) {
+        for (int level = 0; level < levels; ++level) {
+          const int shift = 4 * (levels - 1 - level);
+          tree[level][(static_cast<size_t>(c) << (16 - shift)) + (pixel[c] >> shift)] += delta;
+        }
+      }
+    }
+  };
+
+  for (int y = first; y < first + rows; ++y) {
+    for (int dx = -radius; dx <= radius; ++dx) updateWindow(y, dx, 1);
+    for (int x = 0; x < width; ++x) {
+      if (x > 0) {
+        updateWindow(y, x - radius - 1, -1);
+        updateWindow(y, x + radius, 1);
+      }
+
+      const size_t offset = y * rowSamples + x * channels;
+      for (int c = 0; c < colors; ++c) {
+        int rank = median;
+        int bin = 0;
+        for (int level = 0; level < levels; ++level) {
+          const int shift = 4 * (levels - 1 - level);
+          const uint16_t* children = &tree[level][(static_cast<size_t>(c) << (16 - shift)) + bin * MEDIAN_FINE_BINS];
+          bin = bin * MEDIAN_FINE_BINS + findRank(children, MEDIAN_FINE_BINS, rank);
+        }
+        dst[offset + c] = static_cast<png_uint_16>(bin);
+      }
+      if (alpha) dst[offset + colors] = src[offset + colors]; // Alpha is kept as is
+    }
+    for (int dx = width - 1 - radius; dx <= width - 1 + radius; ++dx) updateWindow(y, dx, -1);
+  }
+}
+
+/////////////////// IMAGE FILTERS ///////////////////////
+
+// @brief: Applies a median filter to an image, in bands of rows on several threads
+// @param `src`: The source pixels
+// @param `dst`: The destination pixels (must not alias `src`)
+// @param `width`, `height`: The image size
+// @param `channels`: The number of channels per pixel
+// @param `radius`: The radius of the window, clamped to [1, MEDIAN_MAX_RADIUS]
+template <typename T>
+void medianPixels(const T* src, T* dst, int width, int height, int channels, int radius) {
+  if (width <= 0 || height <= 0) return;
+  radius = std::clamp(radius, 1, MEDIAN_MAX_RADIUS);
+
+  // Every band first fills its column histograms with 2 * radius + 1 rows, so bands grow with the radius
+  const int bandRows = std::max(MEDIAN_BAND_ROWS, 4 * radius);
+  const size_t bands = (height + bandRows - 1) / bandRows;
+  runJobs(bands, getThreadCount(), [&](size_t band) {
+    const int first = static_cast<int>(band) * bandRows;
+    const int rows = std::min(bandRows, height - first);
+    if constexpr (sizeof(T) == 1) medianBand8(src, dst, width, height, channels, radius, first, rows);
+    else medianBand16(src, dst, width, height, channels, radius, first, rows);
+  });
+}
+
+/////////////////// INSTANTIATIONS //////////////////////
+
+template void medianPixels<png_byte>(const png_byte*, png_byte*, int, int, int, int);
+template void medianPixels<png_uint_16>(const png_uint_16*, png_uint_16*, int, int, int, int);
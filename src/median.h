@@ -0,0 +1,17 @@
+#pragma once
+
+#include <png.h>
+
+/* Constants */
+const int MEDIAN_MAX_RADIUS = 50;
+const int MEDIAN_BAND_ROWS = 64;   // Rows filtered by one job, at least; larger radii get taller bands
+const int MEDIAN_FINE_BINS = 16;   // Bins under each coarse bin of the histograms
+
+/* Image Filters */
+// Replaces every sample with the median of the (2 * radius + 1)^2 window around it, with the edges
+// repeated. Works on 1 (G), 2 (GA), 3 (RGB) or 4 (RGBA) channels and leaves the alpha channel untouched.
+// 8-bit samples use the column histograms of Perreault and Hebert, so the cost per pixel does not
+// depend on the radius. 16-bit samples would need 65536 bins per column, so they slide one window
+// histogram along each row instead, at a cost that grows linearly with the radius.
+// Instantiated for png_byte (8-bit) and png_uint_16 (16-bit) samples.
+template <typename T> void medianPixels(const T* src, T* dst, int width, int height, int channels, int radius);
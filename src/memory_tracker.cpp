@@ -0,0 +1,87 @@
+#include <iomanip>
+#include "memory_tracker.h"
+
+/////////////////// MEMORY TRACKER HELPERS //////////////
+
+// @brief: Raises `peak` to `value` if it is higher
+static void raisePeak(std::atomic<size_t>& peak, size_t value) {
+  size_t previous = peak.load(std::memory_order_relaxed);
+  while (value > previous && !peak.compare_exchange_weak(previous, value, std::memory_order_relaxed)) {}
+}
+
+/////////////////// MEMORY TRACKER CONSTRUCTOR //////////
+
+// @brief: Initializes the tracker with nothing allocated and no budget
+MemoryTracker::MemoryTracker(void) {
+  for (int c = 0; c < MEMORY_CATEGORIES; ++c) {
+    this->current[c] = 0;
+    this->peak[c] = 0;
+  }
+  this->total = 0;
+  this->totalPeak = 0;
+  this->budget = 0;
+}
+
+/////////////////// MEMORY TRACKER METHODS //////////////
+
+// @brief: Returns the tracker shared by the whole program
+MemoryTracker& MemoryTracker::get(void) {
+  static MemoryTracker tracker;
+  return tracker;
+}
+
+// @brief: Returns the name shown for a category
+const char* MemoryTracker::getName(MemoryCategory category) {
+  switch (category) {
+    case MemoryCategory::IMAGE: return "Image";
+    case MemoryCategory::SCRATCH: return "Scratch";
+    case MemoryCategory::HISTORY: return "History";
+    case MemoryCategory::CACHE: return "Cache";
+    case MemoryCategory::TEXTURE: return "Texture";
+  }
+  return "";
+}
+
+// @brief: Counts an allocation
+void MemoryTracker::add(MemoryCategory category, size_t bytes) {
+  const int c = static_cast<int>(category);
+  raisePeak(this->peak[c], this->current[c].fetch_add(bytes, std::memory_order_relaxed) + bytes);
+  raisePeak(this->totalPeak, this->total.fetch_add(bytes, std::memory_order_relaxed) + bytes);
+}
+
+// @brief: Counts a deallocation
+void MemoryTracker::remove(MemoryCategory category, size_t bytes) {
+  this->current[static_cast<int>(category)].fetch_sub(bytes, std::memory_order_relaxed);
+  this->total.fetch_sub(bytes, std::memory_order_relaxed);
+}
+
+// @brief: Returns whether `bytes` more can be allocated without going over the budget
+bool MemoryTracker::fits(size_t bytes) const {
+  const size_t budget = this->budget;
+  return budget == 0 || this->total + bytes <= budget;
+}
+
+// @brief: Prints the current and peak bytes of every category
+void MemoryTracker::printReport(std::ostream& out) const {
+  const double mb = 1024.0 * 1024.0;
+  out << std::fixed << std::setprecision(1);
+  out << "Memory (MB)      current     peak" << std::endl;
+  for (int c = 0; c < MEMORY_CATEGORIES; ++c) {
+    out << "  " << std::left << std::setw(12) << getName(static_cast<MemoryCategory>(c)) << std::right << std::setw(10) << this->current[c] / mb
+        << std::setw(9) << this->peak[c] / mb << std::endl;
+  }
+  out << "  " << std::left << std::setw(12) << "Total" << std::right << std::setw(10) << this->total / mb << std::setw(9) << this->totalPeak / mb << std::endl;
+  if (this->budget) out << "  Budget " << this->budget / mb << std::endl;
+}
+
+/////////////////// MEMORY TRACKER GETTERS //////////////
+
+size_t MemoryTracker::getCurrent(MemoryCategory category) const { return this->current[static_cast<int>(category)]; }
+size_t MemoryTracker::getPeak(MemoryCategory category) const { return this->peak[static_cast<int>(category)]; }
+size_t MemoryTracker::getTotal(void) const { return this->total; }
+size_t MemoryTracker::getTotalPeak(void) const { return this->totalPeak; }
+size_t MemoryTracker::getBudget(void) const { return this->budget; }
+
+/////////////////// MEMORY TRACKER SETTERS //////////////
+
+void MemoryTracker::setBudget(size_t budget) { this->budget = budget; }
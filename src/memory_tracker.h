@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <ostream>
+#include <type_traits>
+#include <png.h>
+
+/* Memory Categories */
+enum class MemoryCategory {
+  IMAGE,   // Original and edited pixel data
+  SCRATCH, // Temporary copies made by filters, uploads and the encoder
+  HISTORY, // Undo history and the data it builds on
+  CACHE,   // Cached pipeline outputs, decoded files and thumbnails
+  TEXTURE  // OpenGL textures
+};
+const int MEMORY_CATEGORIES = 5;
+
+class MemoryTracker {
+private:
+  /* Private Variables */
+  std::atomic<size_t> current[MEMORY_CATEGORIES];
+  std::atomic<size_t> peak[MEMORY_CATEGORIES];
+  std::atomic<size_t> total;
+  std::atomic<size_t> totalPeak;
+  std::atomic<size_t> budget; // 0 means no budget
+
+public:
+  /* Constructor */
+  MemoryTracker(void);
+
+  /* Methods */
+  static MemoryTracker& get(void);
+  static const char* getName(MemoryCategory category);
+  void add(MemoryCategory category, size_t bytes);
+  void remove(MemoryCategory category, size_t bytes);
+  bool fits(size_t bytes) const;
+  void printReport(std::ostream& out) const;
+
+  /* Getters */
+  size_t getCurrent(MemoryCategory category) const;
+  size_t getPeak(MemoryCategory category) const;
+  size_t getTotal(void) const;
+  size_t getTotalPeak(void) const;
+  size_t getBudget(void) const;
+
+  /* Setters */
+  void setBudget(size_t budget);
+};
+
+/* Tracked Allocator */
+// Counts every allocation against a category; containers keep the category of the allocator
+// they were made with when they are copied into, and take the other's when they are moved into
+template <typename T>
+class TrackedAllocator {
+public:
+  using value_type = T;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  MemoryCategory category;
+
+  TrackedAllocator(MemoryCategory category = MemoryCategory::SCRATCH) noexcept : category(category) {}
+  template <typename U>
+  TrackedAllocator(const TrackedAllocator<U>& other) noexcept : category(other.category) {}
+
+  T* allocate(size_t count) {
+    T* memory = std::allocator<T>().allocate(count);
+    MemoryTracker::get().add(this->category, count * sizeof(T));
+    return memory;
+  }
+  void deallocate(T* memory, size_t count) noexcept {
+    MemoryTracker::get().remove(this->category, count * sizeof(T));
+    std::allocator<T>().deallocate(memory, count);
+  }
+};
+
+template <typename T, typename U>
+bool operator==(const TrackedAllocator<T>& a, const TrackedAllocator<U>& b) { return a.category == b.category; }
+template <typename T, typename U>
+bool operator!=(const TrackedAllocator<T>& a, const TrackedAllocator<U>& b) { return a.category != b.category; }
+
+/* Pixel Buffer */
+using PixelBuffer = std::vector<png_byte, TrackedAllocator<png_byte>>;
+
+/* Float Buffer */
+// Intermediate samples of filters that work in floating point
+using FloatBuffer = std::vector<float, TrackedAllocator<float>>;
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <algorithm>
+#include "trace.h"
+
+// @brief: Returns the number of worker threads to use
+inline int getThreadCount(void) {
+  return std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+}
+
+// @brief: Runs `count` jobs on a pool of threads that take the next job from a shared counter
+// @param `count`: The number of jobs
+// @param `threads`: The most threads to use, including the calling thread
+// @param `job`: Called with the index of every job
+template <typename Job>
+void runJobs(size_t count, int threads, Job job) {
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++) {
+      TraceScope scope("Job");
+      job(i);
+    }
+  };
+  std::vector<std::thread> pool;
+  for (size_t t = 1; t < std::min(static_cast<size_t>(threads), count); ++t) pool.emplace_back(worker);
+  worker();
+  for (std::thread& thread : pool) thread.join();
+}
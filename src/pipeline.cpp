@@ -0,0 +1,222 @@
+#include <algorithm>
+#include "pipeline.h"
+
+/////////////////// PIPELINE HELPERS ////////////////////
+
+// @brief: Returns the memory held by a cached output
+static size_t getOutputBytes(const PipelineOutput& output) {
+  return output.data.size() + output.palette.size() * sizeof(png_color) + output.trans.size();
+}
+
+/////////////////// OPERATION METHODS ///////////////////
+
+// @brief: Initializes an enabled operation with neutral parameters
+// @param `type`: The operation type
+Operation::Operation(OperationType type) {
+  this->type = type;
+  this->enabled = true;
+  this->red = 1.0f;
+  this->green = 1.0f;
+  this->blue = 1.0f;
+  this->angle = 0;
+  this->sigma = 2.0f;
+  this->radius = 1.0f;
+  this->amount = 1.0f;
+  this->threshold = 0.0f;
+  this->medianRadius = 1;
+  this->spatial = 16.0f;
+  this->range = 30.0f;
+}
+
+// @brief: Returns whether the operation leaves the image as it is
+bool Operation::isNoOp(void) const {
+  if (!this->enabled) return true;
+  if (this->type == OperationType::RGB) return this->red == 1.0f && this->green == 1.0f && this->blue == 1.0f;
+  if (this->type == OperationType::ROTATE) return this->angle % 360 == 0;
+  if (this->type == OperationType::UNSHARP) return this->amount == 0.0f;
+  return false;
+}
+
+// @brief: Returns whether every output pixel only depends on the same input pixel
+bool Operation::isPointOp(void) const {
+  return this->type == OperationType::INVERT || this->type == OperationType::GRAYSCALE || this->type == OperationType::RGB;
+}
+
+// @brief: Returns whether the operation can run on a stream of rows with a small window
+bool Operation::isStreamable(void) const {
+  return this->isPointOp() || this->type == OperationType::BLUR || this->type == OperationType::SHARPEN;
+}
+
+// @brief: Chains the operation onto the hash of its input
+// Only the parameters that the operation uses are hashed
+// @param `previous`: The hash of the input
+// @return: The hash of the output
+uint64_t Operation::hash(uint64_t previous) const {
+  uint64_t hash = mixHash(previous, &this->type, sizeof(this->type));
+  if (this->type == OperationType::RGB) {
+    hash = mixHash(hash, &this->red, sizeof(this->red));
+    hash = mixHash(hash, &this->green, sizeof(this->green));
+    hash = mixHash(hash, &this->blue, sizeof(this->blue));
+  }
+  if (this->type == OperationType::ROTATE) hash = mixHash(hash, &this->angle, sizeof(this->angle));
+  if (this->type == OperationType::GAUSSIAN) hash = mixHash(hash, &this->sigma, sizeof(this->sigma));
+  if (this->type == OperationType::UNSHARP) {
+    hash = mixHash(hash, &this->radius, sizeof(this->radius));
+    hash = mixHash(hash, &this->amount, sizeof(this->amount));
+    hash = mixHash(hash, &this->threshold, sizeof(this->threshold));
+  }
+  if (this->type == OperationType::MEDIAN) hash = mixHash(hash, &this->medianRadius, sizeof(this->medianRadius));
+  if (this->type == OperationType::BILATERAL) {
+    hash = mixHash(hash, &this->spatial, sizeof(this->spatial));
+    hash = mixHash(hash, &this->range, sizeof(this->range));
+  }
+  return hash;
+}
+
+// @brief: Returns the name shown for the operation
+const char* Operation::getName(void) const {
+  switch (this->type) {
+    case OperationType::INVERT: return "Invert";
+    case OperationType::GRAYSCALE: return "Grayscale";
+    case OperationType::BLUR: return "Blur";
+    case OperationType::SHARPEN: return "Sharpen";
+    case OperationType::UNSHARP: return "Unsharp Mask";
+    case OperationType::RGB: return "RGB";
+    case OperationType::ROTATE: return "Rotate";
+    case OperationType::GAUSSIAN: return "Gaussian";
+    case OperationType::MEDIAN: return "Median";
+    case OperationType::BILATERAL: return "Bilateral";
+  }
+  return "";
+}
+
+bool Operation::operator==(const Operation& other) const {
+  return this->type == other.type && this->enabled == other.enabled && this->red == other.red && this->green == other.green &&
+         this->blue == other.blue && this->angle == other.angle && this->sigma == other.sigma &&
+         this->radius == other.radius && this->amount == other.amount && this->threshold == other.threshold &&
+         this->medianRadius == other.medianRadius && this->spatial == other.spatial && this->range == other.range;
+}
+
+/////////////////// PIPELINE CONSTRUCTOR ////////////////
+
+// @brief: Initializes an empty pipeline
+Pipeline::Pipeline(void) {
+  this->cacheBytes = 0;
+  this->cacheBudget = PIPELINE_CACHE_BYTES;
+  this->clock = 0;
+}
+
+/////////////////// PIPELINE PRIVATE METHODS ////////////
+
+// @brief: Drops the least recently used outputs until `needed` more bytes fit in the budget
+void Pipeline::evict(size_t needed) {
+  while (!this->cache.empty() && this->cacheBytes + needed > this->cacheBudget) {
+    auto oldest = std::min_element(this->cache.begin(), this->cache.end(), [](const CacheEntry& a, const CacheEntry& b) { return a.lastUsed < b.lastUsed; });
+    this->cacheBytes -= getOutputBytes(oldest->output);
+    this->cache.erase(oldest);
+  }
+}
+
+/////////////////// PIPELINE METHODS ///////////////////
+
+// @brief: Appends an operation to the end of the pipeline
+void Pipeline::add(const Operation& operation) {
+  this->operations.push_back(operation);
+}
+
+// @brief: Removes the operation at `index`
+void Pipeline::remove(size_t index) {
+  if (index < this->operations.size()) this->operations.erase(this->operations.begin() + index);
+}
+
+// @brief: Moves the operation at `from` to `to`, shifting the ones in between
+void Pipeline::move(size_t from, size_t to) {
+  if (from >= this->operations.size() || to >= this->operations.size() || from == to) return;
+  Operation operation = this->operations[from];
+  this->operations.erase(this->operations.begin() + from);
+  this->operations.insert(this->operations.begin() + to, operation);
+}
+
+// @brief: Removes every operation
+void Pipeline::clear(void) {
+  this->operations.clear();
+}
+
+// @brief: Returns the chained hash after every operation that changes the image
+// Two prefixes with the same hash produce the same output from the same original, no matter
+// which no-op nodes sit between them.
+// @param `active`: Set to the indices of the operations that change the image
+// @return: The hash of the output of each active operation
+std::vector<uint64_t> Pipeline::getHashes(std::vector<size_t>& active) const {
+  std::vector<uint64_t> hashes;
+  active.clear();
+  uint64_t hash = PIPELINE_HASH_SEED;
+  for (size_t i = 0; i < this->operations.size(); ++i) {
+    if (this->operations[i].isNoOp()) continue;
+    hash = this->operations[i].hash(hash);
+    active.push_back(i);
+    hashes.push_back(hash);
+  }
+  return hashes;
+}
+
+// @brief: Copies a cached output
+// @param `hash`: The hash of the output
+// @param `output`: Set to the cached output
+// @return: Whether the output was cached
+bool Pipeline::lookup(uint64_t hash, PipelineOutput& output) {
+  for (CacheEntry& entry : this->cache) {
+    if (entry.hash != hash) continue;
+    entry.lastUsed = ++this->clock;
+    output = entry.output;
+    return true;
+  }
+  return false;
+}
+
+// @brief: Caches the output of a node, evicting the least recently used outputs if needed
+// Outputs that do not fit in the memory budget are not cached, since the cache is only a shortcut.
+// The output is copied only once it is known to fit.
+// @param `hash`: The hash of the output
+// @param `colorType`, `palette`, `trans`, `data`: The output
+void Pipeline::store(uint64_t hash, int colorType, const std::vector<png_color>& palette, const std::vector<png_byte>& trans, const PixelBuffer& data) {
+  const size_t bytes = data.size() + palette.size() * sizeof(png_color) + trans.size();
+  if (bytes > this->cacheBudget) return;
+  for (CacheEntry& entry : this->cache) {
+    if (entry.hash == hash) {
+      entry.lastUsed = ++this->clock;
+      return;
+    }
+  }
+  this->evict(bytes);
+  if (!MemoryTracker::get().fits(bytes)) return;
+  this->cache.push_back({ hash, ++this->clock, { colorType, palette, trans, PixelBuffer(data, MemoryCategory::CACHE) } });
+  this->cacheBytes += bytes;
+}
+
+// @brief: Drops every cached output, for example when a new original is loaded
+void Pipeline::clearCache(void) {
+  this->cache.clear();
+  this->cacheBytes = 0;
+}
+
+/////////////////// PIPELINE GETTERS ////////////////////
+
+const std::vector<Operation>& Pipeline::getOperations(void) const { return this->operations; }
+Operation& Pipeline::getOperation(size_t index) { return this->operations[index]; }
+size_t Pipeline::size(void) const { return this->operations.size(); }
+bool Pipeline::hasActive(OperationType type) const {
+  return std::any_of(this->operations.begin(), this->operations.end(), [&](const Operation& operation) { return operation.type == type && !operation.isNoOp(); });
+}
+bool Pipeline::isStreamable(void) const {
+  return std::all_of(this->operations.begin(), this->operations.end(), [](const Operation& operation) { return operation.isNoOp() || operation.isStreamable(); });
+}
+size_t Pipeline::getCacheBytes(void) const { return this->cacheBytes; }
+
+/////////////////// PIPELINE SETTERS ////////////////////
+
+void Pipeline::setOperations(const std::vector<Operation>& operations) { this->operations = operations; }
+void Pipeline::setCacheBudget(size_t budget) {
+  this->cacheBudget = budget;
+  this->evict(0);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <png.h>
+#include "memory_tracker.h"
+#include "hash.h"
+
+/* Constants */
+const size_t PIPELINE_CACHE_BYTES = 256 << 20;      // Default memory budget of the cached node outputs
+const uint64_t PIPELINE_HASH_SEED = HASH_SEED;      // The hash of the original image
+
+/* Operation Types */
+enum class OperationType {
+  INVERT,
+  GRAYSCALE,
+  BLUR,
+  SHARPEN,
+  UNSHARP,
+  RGB,
+  ROTATE,
+  GAUSSIAN,
+  MEDIAN,
+  BILATERAL
+};
+
+/* Operation */
+// One node of the pipeline with its parameters
+struct Operation {
+  OperationType type;
+  bool enabled;
+  float red;   // RGB gains
+  float green;
+  float blue;
+  int angle;   // Rotation in degrees
+  float sigma; // Gaussian standard deviation in pixels
+  float radius;     // Unsharp mask blur in pixels
+  float amount;     // Unsharp mask strength
+  float threshold;  // Unsharp mask threshold in 8-bit levels
+  int medianRadius; // Median radius in pixels
+  float spatial;    // Bilateral spatial sigma in pixels
+  float range;      // Bilateral range sigma in 8-bit levels
+
+  Operation(OperationType type);
+  bool isNoOp(void) const;
+  bool isPointOp(void) const;
+  bool isStreamable(void) const;
+  uint64_t hash(uint64_t previous) const;
+  const char* getName(void) const;
+  bool operator==(const Operation& other) const;
+};
+
+/* Pipeline Output */
+// The image as a node left it
+struct PipelineOutput {
+  int colorType;
+  std::vector<png_color> palette;
+  std::vector<png_byte> trans;
+  PixelBuffer data;
+};
+
+class Pipeline {
+private:
+  /* Private Types */
+  struct CacheEntry {
+    uint64_t hash;
+    uint64_t lastUsed;
+    PipelineOutput output;
+  };
+
+  /* Private Variables */
+  std::vector<Operation> operations;
+  std::vector<CacheEntry> cache;
+  size_t cacheBytes;
+  size_t cacheBudget;
+  uint64_t clock;
+
+  /* Private Methods */
+  void evict(size_t needed);
+
+public:
+  /* Constructor */
+  Pipeline(void);
+
+  /* Methods */
+  void add(const Operation& operation);
+  void remove(size_t index);
+  void move(size_t from, size_t to);
+  void clear(void);
+  std::vector<uint64_t> getHashes(std::vector<size_t>& active) const;
+  bool lookup(uint64_t hash, PipelineOutput& output);
+  void store(uint64_t hash, int colorType, const std::vector<png_color>& palette, const std::vector<png_byte>& trans, const PixelBuffer& data);
+  void clearCache(void);
+
+  /* Getters */
+  const std::vector<Operation>& getOperations(void) const;
+  Operation& getOperation(size_t index);
+  size_t size(void) const;
+  bool hasActive(OperationType type) const;
+  bool isStreamable(void) const;
+  size_t getCacheBytes(void) const;
+
+  /* Setters */
+  void setOperations(const std::vector<Operation>& operations);
+  void setCacheBudget(size_t budget);
+};
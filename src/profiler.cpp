@@ -0,0 +1,75 @@
+#include <algorithm>
+#include "profiler.h"
+
+/////////////////// PROFILER METHODS ////////////////////
+
+// @brief: Returns the profiler shared by the whole program
+Profiler& Profiler::get(void) {
+  static Profiler profiler;
+  return profiler;
+}
+
+// @brief: Adds a sample to a stage, creating the stage the first time it runs
+// @param `name`: The stage
+// @param `milliseconds`: How long the stage took
+void Profiler::record(const char* name, double milliseconds) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  auto stage = std::find_if(this->stages.begin(), this->stages.end(), [&](const Stage& s) { return s.name == name; });
+  if (stage == this->stages.end()) {
+    this->stages.push_back({ name, {}, 0, 0.0, 0 });
+    stage = this->stages.end() - 1;
+  }
+  if (stage->samples.size() < PROFILER_SAMPLES) stage->samples.push_back(milliseconds);
+  else stage->samples[stage->next] = milliseconds;
+  stage->next = (stage->next + 1) % PROFILER_SAMPLES;
+  stage->last = milliseconds;
+  ++stage->count;
+}
+
+// @brief: Drops every sample
+void Profiler::clear(void) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  this->stages.clear();
+}
+
+/////////////////// PROFILER GETTERS ////////////////////
+
+// @brief: Returns the last, average and 99th percentile time of every stage over its latest samples
+std::vector<ProfilerStats> Profiler::getStats(void) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  std::vector<ProfilerStats> stats;
+  for (const Stage& stage : this->stages) {
+    std::vector<double> sorted = stage.samples;
+    double sum = 0.0;
+    for (double sample : sorted) sum += sample;
+    size_t rank = (sorted.size() * 99 + 99) / 100 - 1; // Nearest rank
+    std::nth_element(sorted.begin(), sorted.begin() + rank, sorted.end());
+    stats.push_back({ stage.name, stage.last, sum / sorted.size(), sorted[rank], stage.count });
+  }
+  return stats;
+}
+
+// @brief: Returns the latest samples of a stage, oldest first, for plotting
+std::vector<float> Profiler::getSamples(const char* name) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  std::vector<float> samples;
+  for (const Stage& stage : this->stages) {
+    if (stage.name != name) continue;
+    const size_t first = stage.samples.size() < PROFILER_SAMPLES ? 0 : stage.next;
+    for (size_t i = 0; i < stage.samples.size(); ++i) samples.push_back(static_cast<float>(stage.samples[(first + i) % stage.samples.size()]));
+  }
+  return samples;
+}
+
+/////////////////// SCOPED TIMER ////////////////////////
+
+// @brief: Starts timing a stage until the timer goes out of scope
+// @param `name`: The stage, which must outlive the profiler
+ScopedTimer::ScopedTimer(const char* name) : trace(name) {
+  this->name = name;
+  this->start = std::chrono::steady_clock::now();
+}
+
+ScopedTimer::~ScopedTimer(void) {
+  Profiler::get().record(this->name, std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - this->start).count());
+}
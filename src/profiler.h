@@ -0,0 +1,62 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <cstdint>
+#include "trace.h"
+
+/* Constants */
+const size_t PROFILER_SAMPLES = 240; // Latest samples kept per stage for the average, p99 and plot
+
+/* Profiler Stats */
+// Timings of one stage in milliseconds
+struct ProfilerStats {
+  std::string name;
+  double last;
+  double average;
+  double p99;
+  uint64_t count; // Times the stage ran since the last clear
+};
+
+class Profiler {
+private:
+  /* Private Types */
+  struct Stage {
+    std::string name;
+    std::vector<double> samples; // Ring of the latest samples
+    size_t next;
+    double last;
+    uint64_t count;
+  };
+
+  /* Private Variables */
+  std::vector<Stage> stages; // In the order they first ran
+  std::mutex lock;           // Stages are timed from the loader and worker threads too
+
+public:
+  /* Methods */
+  static Profiler& get(void);
+  void record(const char* name, double milliseconds);
+  void clear(void);
+
+  /* Getters */
+  std::vector<ProfilerStats> getStats(void);
+  std::vector<float> getSamples(const char* name);
+};
+
+class ScopedTimer {
+private:
+  /* Private Variables */
+  const char* name;
+  std::chrono::steady_clock::time_point start;
+  TraceScope trace; // Every timed stage also shows up in traces
+
+public:
+  /* Constructor */
+  ScopedTimer(const char* name);
+
+  /* Destructor */
+  ~ScopedTimer(void);
+};
@@ -1,42 +1,152 @@
+#include <algorithm>
+#include <cctype>
 #include "render.h"
 
 /////////////////// RENDERER CONSTRUCTOR ///////////////////
 
 // @brief: Initializes the renderer class with default values
-Renderer::Renderer(void) {
+Renderer::Renderer(void) : saveDialog(ImGuiFileBrowserFlags_EnterNewFilename | ImGuiFileBrowserFlags_CreateNewDir),
+                           traceDialog(ImGuiFileBrowserFlags_EnterNewFilename | ImGuiFileBrowserFlags_CreateNewDir) {
   // Initialize file dialog
   this->fileDialog.SetTitle("Select PNG file");
   this->fileDialog.SetTypeFilters({ ".png" });
 
+  // Initialize save dialog
+  this->saveDialog.SetTitle("Save PNG file as");
+  this->saveDialog.SetTypeFilters({ ".png" });
+  this->saveProfile = SaveProfile::BALANCED;
+
+  // Initialize trace dialog
+  this->traceDialog.SetTitle("Export trace as");
+  this->traceDialog.SetTypeFilters({ ".json" });
+  this->loadDone = false;
+  this->shownPasses = 0;
+  this->showTimings = false;
+  this->showMemory = false;
+  this->selectedTab = nullptr;
+
   // Initialize icons
-  this->invertIcon.load("assets/invert.png");
-  this->invertIcon.createOpenGLTexture();
-  this->grayscaleIcon.load("assets/grayscale.png");
-  this->grayscaleIcon.createOpenGLTexture();
-  this->blurIcon.load("assets/blur.png");
-  this->blurIcon.createOpenGLTexture();
-  this->sharpenIcon.load("assets/sharpen.png");
-  this->sharpenIcon.createOpenGLTexture();
-  this->rotateIcon.load("assets/rotate.png");
-  this->rotateIcon.createOpenGLTexture();
+  this->icons.createOpenGLTexture();
 }
 
 /////////////////// RENDERER DESTRUCTOR ////////////////////
 
 // @brief: Deallocates the renderer class
+// The icon atlas releases its texture in its own destructor
 Renderer::~Renderer(void) {
-  // Deallocate file dialog
+  // Stop any image still loading
+  this->cancelLoading();
+
+  // Deallocate file dialogs
   this->fileDialog.ClearSelected();
+  this->saveDialog.ClearSelected();
+  this->traceDialog.ClearSelected();
+}
+
+/////////////////// RENDERER PRIVATE METHODS //////////////
+
+// @brief: Starts decoding an image on a background thread
+// The open images stay usable until the new one is ready and opens in a tab of its own
+// @param `path`: The path to the image file
+void Renderer::startLoading(const std::string path) {
+  this->cancelLoading();
+  this->pendingImage = std::make_unique<Image>();
+  this->pendingPath = path;
+  this->loadProgress.rows = 0;
+  this->loadProgress.total = 0;
+  this->loadProgress.cancel = false;
+  this->loadProgress.passes = 0;
+  this->shownPasses = 0;
+  this->loadDone = false;
+  Image* image = this->pendingImage.get();
+  this->loader = std::thread([this, image, path]() {
+    image->load(path, &this->loadProgress);
+    this->loadDone = true;
+  });
+}
+
+// @brief: Cancels the background load, if any, and waits for it to stop
+void Renderer::cancelLoading(void) {
+  if (!this->loader.joinable()) return;
+  this->loadProgress.cancel = true;
+  this->loader.join();
+  this->pendingImage.reset();
+}
+
+// @brief: Renders the thumbnails of the PNG files in the file dialog's folder next to it
+// Only the rows on screen request thumbnails, so a large folder costs no more than the part of it shown
+void Renderer::renderThumbnailWindow(void) {
+  if (!this->fileDialog.IsOpened()) {
+    if (!this->thumbnailDirectory.empty()) this->thumbnails.cancel();
+    this->thumbnailDirectory.clear();
+    this->thumbnails.upload();
+    return;
+  }
 
-  // Deallocate icons
-  this->invertIcon.~Image();
-  this->grayscaleIcon.~Image();
-  this->blurIcon.~Image();
-  this->sharpenIcon.~Image();
-  this->rotateIcon.~Image();
+  // List the folder again when it changes
+  const std::filesystem::path& directory = this->fileDialog.GetPwd();
+  if (directory != this->thumbnailDirectory) {
+    this->thumbnails.cancel();
+    this->thumbnailDirectory = directory;
+    this->thumbnailFiles.clear();
+    std::error_code error;
+    for (const auto& file : std::filesystem::directory_iterator(directory, error)) {
+      std::string extension = file.path().extension().string();
+      std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return std::tolower(c); });
+      if (extension == ".png" && file.is_regular_file(error)) this->thumbnailFiles.push_back(file.path());
+    }
+    std::sort(this->thumbnailFiles.begin(), this->thumbnailFiles.end());
+  }
+
+  ImGui::SetNextWindowPos(ImVec2(SCREEN_WIDTH / 2, MARGIN), ImGuiCond_Once);
+  ImGui::SetNextWindowSize(ImVec2(SCREEN_WIDTH / 2 - MARGIN, SCREEN_HEIGHT - MARGIN * 2), ImGuiCond_Once);
+  ImGui::Begin("Thumbnails", nullptr, ImGuiWindowFlags_NoCollapse);
+  const ImGuiStyle& style = ImGui::GetStyle();
+  const ImVec2 box(THUMBNAIL_SIZE + style.FramePadding.x * 2, THUMBNAIL_SIZE + style.FramePadding.y * 2);
+  const float cellWidth = box.x + style.ItemSpacing.x;
+  const float cellHeight = box.y + ImGui::GetTextLineHeight() + style.ItemSpacing.y * 2;
+  const int columns = std::max(1, static_cast<int>((ImGui::GetContentRegionAvail().x + style.ItemSpacing.x) / cellWidth));
+  const int count = static_cast<int>(this->thumbnailFiles.size());
+
+  ImGuiListClipper clipper;
+  clipper.Begin((count + columns - 1) / columns, cellHeight);
+  while (clipper.Step()) {
+    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row) {
+      const ImVec2 origin = ImGui::GetCursorPos();
+      for (int column = 0; column < columns && row * columns + column < count; ++column) {
+        const int i = row * columns + column;
+        const std::string path = this->thumbnailFiles[i].string();
+        const std::string name = this->thumbnailFiles[i].filename().string();
+        const float x = origin.x + column * cellWidth;
+
+        // Center the thumbnail in its box; a plain button stands in until it is ready
+        ImVec2 size;
+        ImTextureID texture = this->thumbnails.request(path, size);
+        ImGui::PushID(i);
+        ImGui::SetCursorPos(ImVec2(x + (THUMBNAIL_SIZE - size.x) / 2, origin.y + (THUMBNAIL_SIZE - size.y) / 2));
+        bool pressed = texture ? ImGui::ImageButton(texture, size) : ImGui::Button("##Thumbnail", box);
+        if (ImGui::IsItemHovered()) ImGui::SetTooltip("%s", name.c_str());
+        ImGui::PopID();
+
+        // The file name, cut at the edge of the box
+        ImGui::SetCursorPos(ImVec2(x, origin.y + box.y + style.ItemSpacing.y));
+        const ImVec2 corner = ImGui::GetCursorScreenPos();
+        ImGui::PushClipRect(corner, ImVec2(corner.x + box.x, corner.y + ImGui::GetTextLineHeight()), true);
+        ImGui::TextUnformatted(name.c_str());
+        ImGui::PopClipRect();
 
-  // Deallocate renderer
-  delete this;
+        if (pressed) {
+          this->startLoading(path);
+          this->fileDialog.Close();
+        }
+      }
+      ImGui::SetCursorPos(origin);
+      ImGui::Dummy(ImVec2(columns * cellWidth, cellHeight - style.ItemSpacing.y));
+    }
+  }
+  clipper.End();
+  ImGui::End();
+  this->thumbnails.upload();
 }
 
 /////////////////// RENDERER METHODS //////////////////////
@@ -54,17 +164,39 @@ void Renderer::renderMainMenu(GLFWwindow* window, ImGuiIO& io, std::unique_ptr<I
   bool save = false;
   bool saveAs = false;
   bool quit = false;
+  bool undo = false;
+  bool redo = false;
+
+  // A document whose edited pixels could not be computed again within the memory budget cannot be saved or edited
+  const bool resident = !image->isLoaded() || image->isResident();
 
   // Render the menu bar
   if (ImGui::BeginMenuBar()) {
     if (ImGui::BeginMenu("File")) {
       if (ImGui::MenuItem("Open", "Ctrl+O")) open = true;
-      if (ImGui::MenuItem("Save", "Ctrl+S")) save = true;
-      if (ImGui::MenuItem("Save As", "Ctrl+Shift+S")) saveAs = true;
+      if (ImGui::MenuItem("Save", "Ctrl+S", false, resident)) save = true;
+      if (ImGui::MenuItem("Save As", "Ctrl+Shift+S", false, resident)) saveAs = true;
+      if (ImGui::BeginMenu("Save Profile")) {
+        if (ImGui::MenuItem("Fastest", nullptr, this->saveProfile == SaveProfile::FASTEST)) this->saveProfile = SaveProfile::FASTEST;
+        if (ImGui::MenuItem("Balanced", nullptr, this->saveProfile == SaveProfile::BALANCED)) this->saveProfile = SaveProfile::BALANCED;
+        if (ImGui::MenuItem("Smallest", nullptr, this->saveProfile == SaveProfile::SMALLEST)) this->saveProfile = SaveProfile::SMALLEST;
+        ImGui::EndMenu();
+      }
       ImGui::Separator();
       if (ImGui::MenuItem("Quit", "Ctrl+Q")) quit = true;
       ImGui::EndMenu();
     }
+    if (ImGui::BeginMenu("Edit")) {
+      if (ImGui::MenuItem("Undo", "Ctrl+Z", false, resident && image->canUndo())) undo = true;
+      if (ImGui::MenuItem("Redo", "Ctrl+Y", false, resident && image->canRedo())) redo = true;
+      ImGui::EndMenu();
+    }
+    if (ImGui::BeginMenu("View")) {
+      ImGui::MenuItem("Timings", nullptr, &this->showTimings);
+      ImGui::MenuItem("Memory", nullptr, &this->showMemory);
+      if (ImGui::MenuItem("Export Trace", nullptr, false, TAP_TRACE)) this->traceDialog.Open();
+      ImGui::EndMenu();
+    }
     ImGui::EndMenuBar();
   }
 
@@ -74,6 +206,8 @@ void Renderer::renderMainMenu(GLFWwindow* window, ImGuiIO& io, std::unique_ptr<I
   if (ctrl && io.KeysDown[ImGuiKey_S]) save = true;
   if (ctrl && io.KeysDown[ImGuiKey_S] && io.KeyShift) saveAs = true;
   if (ctrl && io.KeysDown[ImGuiKey_Q]) quit = true;
+  if (ctrl && ImGui::IsKeyPressed(ImGuiKey_Z, false)) undo = true; // No key repeat, one step per press
+  if (ctrl && ImGui::IsKeyPressed(ImGuiKey_Y, false)) redo = true;
 
   // Process menu bar actions
   if (open) {
@@ -83,17 +217,27 @@ void Renderer::renderMainMenu(GLFWwindow* window, ImGuiIO& io, std::unique_ptr<I
     this->fileDialog.Open();
   }
 
+  if (saveAs) save = false; // Ctrl+Shift+S also matches Ctrl+S
+
+  if (!resident && (save || saveAs || undo || redo)) {
+    ImGui::OpenPopup("Error: Not enough memory budget");
+    save = saveAs = undo = redo = false;
+  }
+
   if (save) {
-    if (image->isLoaded()) image->save();
-    else ImGui::OpenPopup("Error: No PNG file loaded");
+    if (!image->isLoaded()) ImGui::OpenPopup("Error: No PNG file loaded");
+    else if (!image->save(this->saveProfile)) ImGui::OpenPopup("Error: Failed to save PNG file");
   }
 
   if (saveAs) {
-    // TODO - Implement this function
+    if (image->isLoaded()) this->saveDialog.Open();
+    else ImGui::OpenPopup("Error: No PNG file loaded");
   }
 
   if (quit) glfwSetWindowShouldClose(window, true);
 
+  if (image->isLoaded() && ((undo && image->undo()) || (redo && image->redo()))) image->updateOpenGLTexture();
+
   // Render the main menu
   if (!image->isLoaded()) {
     ImGui::SetCursorPosX(ImGui::GetWindowWidth() / 2 - ImGui::CalcTextSize("No PNG file loaded").x / 2);
@@ -101,19 +245,95 @@ void Renderer::renderMainMenu(GLFWwindow* window, ImGuiIO& io, std::unique_ptr<I
     ImGui::Text("No PNG file loaded");
   }
 
+  if (ImGui::BeginPopupModal("Error: Failed to save PNG file", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+    ImGui::Text("The file could not be written.");
+    if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
+    ImGui::EndPopup();
+  }
+
+  if (ImGui::BeginPopupModal("Error: Not enough memory budget", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+    ImGui::Text("The image does not fit in the memory budget. Close other tabs to free memory.");
+    if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
+    ImGui::EndPopup();
+  }
+
   ImGui::End();
 }
 
 // @brief: Renders the file dialog
 // @param `window`: The GLFW window
-// @param `image`: The image to render
-void Renderer::renderFileDialog(GLFWwindow* window, std::unique_ptr<Image>& image) {
+// @param `workspace`: The open documents; loaded images are added to it and the active one is saved
+void Renderer::renderFileDialog(GLFWwindow* window, Workspace& workspace) {
   this->fileDialog.Display();
   if (this->fileDialog.HasSelected()) {
-    image->load(this->fileDialog.GetSelected().string());
+    this->startLoading(this->fileDialog.GetSelected().string());
     this->fileDialog.ClearSelected();
     this->fileDialog.Close();
   }
+  this->renderThumbnailWindow();
+
+  // Show the progress of the background load
+  if (this->loader.joinable()) {
+    if (this->loadDone) {
+      this->loader.join();
+      if (this->pendingImage->isLoaded() && this->pendingImage->getTexture()) this->pendingImage->updateOpenGLTexture();
+      if (this->pendingImage->isLoaded()) workspace.open(std::move(this->pendingImage));
+      else ImGui::OpenPopup("Error: Failed to load PNG file");
+      this->pendingImage.reset();
+    } else {
+      // Upload the preview of interlaced images after every Adam7 pass
+      int passes = this->loadProgress.passes;
+      if (passes > this->shownPasses && this->loadProgress.lock.try_lock()) {
+        if (!this->pendingImage->getTexture()) this->pendingImage->createOpenGLTexture();
+        else this->pendingImage->updateOpenGLTexture();
+        this->loadProgress.lock.unlock();
+        this->shownPasses = passes;
+      }
+
+      int total = this->loadProgress.total;
+      float fraction = total > 0 ? static_cast<float>(this->loadProgress.rows) / total : 0.0f;
+      ImGui::SetNextWindowPos(ImVec2(SCREEN_WIDTH / 2 - SCREEN_WIDTH / 8, SCREEN_HEIGHT / 2), ImGuiCond_Once);
+      ImGui::SetNextWindowSize(ImVec2(SCREEN_WIDTH / 4, 0), ImGuiCond_Once);
+      ImGui::Begin("Loading", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoCollapse);
+      ImGui::TextUnformatted(this->pendingPath.c_str());
+      ImGui::ProgressBar(fraction);
+      if (ImGui::Button("Cancel")) this->cancelLoading();
+      ImGui::End();
+    }
+  }
+
+  if (ImGui::BeginPopupModal("Error: Failed to load PNG file", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+    ImGui::Text("The selected file could not be decoded.");
+    if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
+    ImGui::EndPopup();
+  }
+
+  this->saveDialog.Display();
+  if (this->saveDialog.HasSelected()) {
+    workspace.getActive()->setPath(this->saveDialog.GetSelected().string());
+    if (!workspace.getActive()->save(this->saveProfile)) ImGui::OpenPopup("Error: Failed to save PNG file");
+    this->saveDialog.ClearSelected();
+    this->saveDialog.Close();
+  }
+
+  if (ImGui::BeginPopupModal("Error: Failed to save PNG file", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+    ImGui::Text("The file could not be written.");
+    if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
+    ImGui::EndPopup();
+  }
+
+  this->traceDialog.Display();
+  if (this->traceDialog.HasSelected()) {
+    if (!Tracer::get().write(this->traceDialog.GetSelected().string())) ImGui::OpenPopup("Error: Failed to export trace");
+    this->traceDialog.ClearSelected();
+    this->traceDialog.Close();
+  }
+
+  if (ImGui::BeginPopupModal("Error: Failed to export trace", nullptr, ImGuiWindowFlags_AlwaysAutoResize)) {
+    ImGui::Text("The trace file could not be written.");
+    if (ImGui::Button("OK")) ImGui::CloseCurrentPopup();
+    ImGui::EndPopup();
+  }
 }
 
 // @brief: Renders the control panel
@@ -125,48 +345,242 @@ void Renderer::renderControlPanel(GLFWwindow* window, std::unique_ptr<Image>& im
   ImGui::Begin("Control Panel", nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
 
   // Image editing functions
+  // Add operations to the end of the pipeline
+  // Buttons commit right away, sliders once they are released
+  Pipeline& pipeline = image->getPipeline();
   bool update = false;
-  if (ImGui::ImageButton(this->invertIcon.getTexture(), ImVec2(32, 32))) { image->setInvert(!image->isInvert()); update = true; }
-  if (ImGui::ImageButton(this->grayscaleIcon.getTexture(), ImVec2(32, 32))) { image->setGrayscale(!image->isGrayscale()); update = true; }
-  if (ImGui::ImageButton(this->blurIcon.getTexture(), ImVec2(32, 32))) { image->setBlur(!image->isBlur()); update = true; }
-  if (ImGui::ImageButton(this->sharpenIcon.getTexture(), ImVec2(32, 32))) { image->setSharpen(!image->isSharpen()); update = true; }
-  if (ImGui::SliderFloat("Red", &image->red, 0.0f, 1.0f)) update = true;
-  if (ImGui::SliderFloat("Green", &image->green, 0.0f, 1.0f)) update = true;
-  if (ImGui::SliderFloat("Blue", &image->blue, 0.0f, 1.0f)) update = true;
-
-  static bool rotate = false;
-  if (ImGui::ImageButton(this->rotateIcon.getTexture(), ImVec2(32, 32))) rotate = !rotate;
-  if (rotate && ImGui::SliderInt("Angle", &image->rotateAngle, -180, 180)) update = true;
+  bool commit = false;
+  if (this->icons.button(ICON_INVERT, ImVec2(32, 32))) { pipeline.add(Operation(OperationType::INVERT)); update = commit = true; }
+  if (this->icons.button(ICON_GRAYSCALE, ImVec2(32, 32))) { pipeline.add(Operation(OperationType::GRAYSCALE)); update = commit = true; }
+  if (this->icons.button(ICON_BLUR, ImVec2(32, 32))) { pipeline.add(Operation(OperationType::BLUR)); update = commit = true; }
+  if (this->icons.button(ICON_SHARPEN, ImVec2(32, 32))) { pipeline.add(Operation(OperationType::SHARPEN)); update = commit = true; }
+  if (this->icons.button(ICON_ROTATE, ImVec2(32, 32))) { pipeline.add(Operation(OperationType::ROTATE)); update = commit = true; }
+  if (ImGui::Button("RGB", ImVec2(40, 40))) { pipeline.add(Operation(OperationType::RGB)); update = commit = true; }
+  if (ImGui::Button("Gauss", ImVec2(40, 40))) { pipeline.add(Operation(OperationType::GAUSSIAN)); update = commit = true; }
+  if (ImGui::Button("Unsharp", ImVec2(56, 40))) { pipeline.add(Operation(OperationType::UNSHARP)); update = commit = true; }
+  if (ImGui::Button("Median", ImVec2(48, 40))) { pipeline.add(Operation(OperationType::MEDIAN)); update = commit = true; }
+  if (ImGui::Button("Bilateral", ImVec2(64, 40))) { pipeline.add(Operation(OperationType::BILATERAL)); update = commit = true; }
+
+  // Edit, reorder and remove the operations, which run from top to bottom
+  ImGui::Separator();
+  for (size_t i = 0; i < pipeline.size(); ++i) {
+    Operation& operation = pipeline.getOperation(i);
+    bool moved = false;
+    ImGui::PushID(static_cast<int>(i));
+    if (ImGui::Checkbox(operation.getName(), &operation.enabled)) update = commit = true;
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##up", ImGuiDir_Up) && i > 0) { pipeline.move(i, i - 1); moved = true; }
+    ImGui::SameLine();
+    if (ImGui::ArrowButton("##down", ImGuiDir_Down) && i + 1 < pipeline.size()) { pipeline.move(i, i + 1); moved = true; }
+    ImGui::SameLine();
+    if (ImGui::SmallButton("X")) { pipeline.remove(i); moved = true; }
+    if (!moved && operation.type == OperationType::RGB) {
+      if (ImGui::SliderFloat("Red", &operation.red, 0.0f, 1.0f)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+      if (ImGui::SliderFloat("Green", &operation.green, 0.0f, 1.0f)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+      if (ImGui::SliderFloat("Blue", &operation.blue, 0.0f, 1.0f)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+    }
+    if (!moved && operation.type == OperationType::ROTATE) {
+      if (ImGui::SliderInt("Angle", &operation.angle, -180, 180)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+    }
+    if (!moved && operation.type == OperationType::UNSHARP) {
+      if (ImGui::SliderFloat("Radius", &operation.radius, GAUSSIAN_MIN_SIGMA, GAUSSIAN_MAX_SIGMA, "%.1f", ImGuiSliderFlags_Logarithmic)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+      if (ImGui::SliderFloat("Amount", &operation.amount, 0.0f, UNSHARP_MAX_AMOUNT, "%.2f")) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+      if (ImGui::SliderFloat("Threshold", &operation.threshold, 0.0f, UNSHARP_MAX_THRESHOLD, "%.0f")) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+    }
+    if (!moved && operation.type == OperationType::GAUSSIAN) {
+      if (ImGui::SliderFloat("Sigma", &operation.sigma, GAUSSIAN_MIN_SIGMA, GAUSSIAN_MAX_SIGMA, "%.1f", ImGuiSliderFlags_Logarithmic)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+    }
+    if (!moved && operation.type == OperationType::MEDIAN) {
+      if (ImGui::SliderInt("Radius", &operation.medianRadius, 1, MEDIAN_MAX_RADIUS)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+    }
+    if (!moved && operation.type == OperationType::BILATERAL) {
+      if (ImGui::SliderFloat("Spatial", &operation.spatial, BILATERAL_MIN_SPATIAL, BILATERAL_MAX_SPATIAL, "%.0f", ImGuiSliderFlags_Logarithmic)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+      if (ImGui::SliderFloat("Range", &operation.range, BILATERAL_MIN_RANGE, BILATERAL_MAX_RANGE, "%.0f", ImGuiSliderFlags_Logarithmic)) update = true;
+      if (ImGui::IsItemDeactivatedAfterEdit()) commit = true;
+    }
+    ImGui::PopID();
+
+    // The list changed under the loop, so draw the rest next frame
+    if (moved) {
+      update = commit = true;
+      break;
+    }
+  }
 
   // Apply the selected functions
   if (update) {
-    image->reset();
-    if (image->isInvert()) image->invert();
-    if (image->isGrayscale()) image->grayscale();
-    if (image->isBlur()) image->blur();
-    if (image->isSharpen()) image->sharpen();
-    image->rgb();
-    image->rotate();
+    image->apply();
     image->updateOpenGLTexture();
   }
+  if (commit) image->commit();
+  if (image->isOverBudget()) ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Not enough memory budget to apply");
+
+  // Histogram of every channel of the edited image
+  // Samples are shown in 8-bit bins; a warning marks color channels that clip at either end
+  ImGui::Separator();
+  const Histogram& histogram = image->getHistogram();
+  const int channels = histogram.getChannels();
+  const bool color = channels >= 3;
+  const bool alpha = channels == 2 || channels == 4;
+  const char* names[] = { color ? "Red" : "Gray", "Green", "Blue" };
+  const float width = ImGui::GetContentRegionAvail().x;
+  for (int c = 0; c < channels; ++c) {
+    const bool isAlpha = alpha && c == channels - 1;
+    const char* name = isAlpha ? "Alpha" : names[c];
+    const uint64_t* counts = histogram.getCounts(c);
+    float bins[HISTOGRAM_BINS];
+    for (int i = 0; i < HISTOGRAM_BINS; ++i) bins[i] = static_cast<float>(counts[i]);
+    ImGui::PushID(c);
+    ImGui::PlotHistogram("##histogram", bins, HISTOGRAM_BINS, 0, name, 0.0f, FLT_MAX, ImVec2(width, 48));
+    ImGui::PopID();
+    ImGui::Text("Min %d  Max %d  Mean %.1f", histogram.getMin(c), histogram.getMax(c), histogram.getMean(c));
+    if (isAlpha) continue;
+    if (histogram.getClippedLow(c) >= HISTOGRAM_CLIP_WARNING) ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "%.1f%% clipped to black", histogram.getClippedLow(c) * 100.0f);
+    if (histogram.getClippedHigh(c) >= HISTOGRAM_CLIP_WARNING) ImGui::TextColored(ImVec4(1.0f, 0.6f, 0.0f, 1.0f), "%.1f%% clipped to white", histogram.getClippedHigh(c) * 100.0f);
+  }
 
   ImGui::End();
 }
 
-// @brief: Renders the image editor window
+// @brief: Renders the image editor window, with a tab for every open document
 // @param `window`: The GLFW window
-// @param `image`: The image to render
-void Renderer::renderImageEditorWindow(GLFWwindow* window, std::unique_ptr<Image>& image) {
+// @param `workspace`: The open documents; picking or closing a tab changes the active one
+void Renderer::renderImageEditorWindow(GLFWwindow* window, Workspace& workspace) {
+  // Show the preview of an interlaced image while it decodes
+  const bool preview = this->pendingImage && this->pendingImage->getTexture();
+  if (workspace.size() == 0 && !preview) return;
+
   ImGui::SetNextWindowPos(ImVec2(SCREEN_WIDTH / 6 + MARGIN * 2, MARGIN), ImGuiCond_Once);
   ImGui::SetNextWindowSize(ImVec2(5 * SCREEN_WIDTH / 6 - MARGIN * 3, SCREEN_HEIGHT - MARGIN * 2), ImGuiCond_Once);
-  ImGui::Begin(image->getPath().c_str(), nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
+  const std::string title = (preview ? this->pendingPath : workspace.getActive()->getPath()) + "###Image Editor";
+  ImGui::Begin(title.c_str(), nullptr, ImGuiWindowFlags_NoResize | ImGuiWindowFlags_NoMove | ImGuiWindowFlags_NoCollapse);
 
-  ImVec2 windowPos = ImGui::GetWindowPos();
-  ImVec2 windowSize = ImGui::GetWindowSize();
-  ImVec2 imagePos = ImVec2(windowPos.x + windowSize.x / 2.0f - image->getWidth() / 2.0f, windowPos.y + windowSize.y / 2.0f - image->getHeight() / 2.0f);
+  // The workspace decides which tab is selected: clicks activate a document, and the tab bar is told
+  // whenever the active one changed elsewhere, e.g. when a file was opened or a tab was closed.
+  // Tabs are told apart by their image, since two tabs can show the same file.
+  if (ImGui::BeginTabBar("Documents", ImGuiTabBarFlags_FittingPolicyScroll)) {
+    const Image* active = workspace.getActive().get();
+    const Image* selected = nullptr;
+    size_t closed = workspace.size();
+    for (size_t i = 0; i < workspace.size(); ++i) {
+      const Image* document = workspace.getDocument(i).get();
+      const std::string label = std::filesystem::path(document->getPath()).filename().string() + "###" + std::to_string(reinterpret_cast<uintptr_t>(document));
+      const ImGuiTabItemFlags flags = document == active && this->selectedTab != active ? ImGuiTabItemFlags_SetSelected : 0;
+      bool open = true;
+      if (ImGui::BeginTabItem(label.c_str(), &open, flags)) {
+        selected = document;
+        ImGui::EndTabItem();
+      }
+      if (ImGui::IsItemClicked() && open && document != active) workspace.activate(i);
+      if (!open) closed = i;
+    }
+    ImGui::EndTabBar();
+    this->selectedTab = selected;
+    workspace.close(closed);
+  }
 
-  ImGui::SetCursorPos(ImVec2(imagePos.x - windowPos.x, imagePos.y - windowPos.y));
-  ImGui::Image(image->getTexture(), ImVec2(image->getWidth(), image->getHeight()));
+  // A tab that was just shown gets its texture back here, so that it does not flash empty for a frame
+  Image* image = preview ? this->pendingImage.get() : workspace.getActive().get();
+  if (image->isLoaded() && image->isResident() && !image->getTexture()) image->createOpenGLTexture();
+  if (image->getTexture()) {
+    ImVec2 cursor = ImGui::GetCursorPos();
+    ImVec2 available = ImGui::GetContentRegionAvail();
+    ImGui::SetCursorPos(ImVec2(cursor.x + available.x / 2.0f - image->getWidth() / 2.0f, cursor.y + available.y / 2.0f - image->getHeight() / 2.0f));
+    ImGui::Image(image->getTexture(), ImVec2(image->getWidth(), image->getHeight()));
+  } else if (image->isLoaded() && !image->isResident()) {
+    ImGui::TextColored(ImVec4(1.0f, 0.3f, 0.3f, 1.0f), "Not enough memory budget to show this image; close other tabs to free memory");
+  }
 
   ImGui::End();
-}
\ No newline at end of file
+}
+
+// @brief: Renders the timings of every stage and the recent frame times, if enabled in the View menu
+void Renderer::renderTimingsWindow(void) {
+  if (!this->showTimings) return;
+  ImGui::SetNextWindowPos(ImVec2(SCREEN_WIDTH - SCREEN_WIDTH / 4 - MARGIN * 2, MARGIN * 6), ImGuiCond_Once);
+  ImGui::SetNextWindowSize(ImVec2(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 3), ImGuiCond_Once);
+  ImGui::Begin("Timings", &this->showTimings, ImGuiWindowFlags_NoCollapse);
+
+  // Frame times, oldest first
+  std::vector<float> frames = Profiler::get().getSamples("Frame");
+  if (!frames.empty()) ImGui::PlotLines("##frames", frames.data(), static_cast<int>(frames.size()), 0, "Frame (ms)", 0.0f, FLT_MAX, ImVec2(ImGui::GetContentRegionAvail().x, 48));
+
+  // Last, average and p99 milliseconds of every stage over its latest samples
+  if (ImGui::BeginTable("##stages", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+    ImGui::TableSetupColumn("Stage");
+    ImGui::TableSetupColumn("Last");
+    ImGui::TableSetupColumn("Avg");
+    ImGui::TableSetupColumn("p99");
+    ImGui::TableHeadersRow();
+    for (const ProfilerStats& stats : Profiler::get().getStats()) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(stats.name.c_str());
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", stats.last);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", stats.average);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.2f", stats.p99);
+    }
+    ImGui::EndTable();
+  }
+  if (ImGui::Button("Clear")) Profiler::get().clear();
+
+  ImGui::End();
+}
+
+// @brief: Renders the current and peak memory of every category, if enabled in the View menu
+void Renderer::renderMemoryWindow(void) {
+  if (!this->showMemory) return;
+  ImGui::SetNextWindowPos(ImVec2(SCREEN_WIDTH - SCREEN_WIDTH / 4 - MARGIN * 2, SCREEN_HEIGHT / 2), ImGuiCond_Once);
+  ImGui::SetNextWindowSize(ImVec2(SCREEN_WIDTH / 4, SCREEN_HEIGHT / 3), ImGuiCond_Once);
+  ImGui::Begin("Memory", &this->showMemory, ImGuiWindowFlags_NoCollapse);
+
+  MemoryTracker& tracker = MemoryTracker::get();
+  const float mb = 1024.0f * 1024.0f;
+  if (ImGui::BeginTable("##memory", 3, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg)) {
+    ImGui::TableSetupColumn("MB");
+    ImGui::TableSetupColumn("Current");
+    ImGui::TableSetupColumn("Peak");
+    ImGui::TableHeadersRow();
+    for (int c = 0; c < MEMORY_CATEGORIES; ++c) {
+      MemoryCategory category = static_cast<MemoryCategory>(c);
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(MemoryTracker::getName(category));
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", tracker.getCurrent(category) / mb);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.1f", tracker.getPeak(category) / mb);
+    }
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGui::TextUnformatted("Total");
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f", tracker.getTotal() / mb);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f", tracker.getTotalPeak() / mb);
+    ImGui::EndTable();
+  }
+
+  // Loads and edits that would go over the budget are refused; 0 means no budget
+  int budget = static_cast<int>(tracker.getBudget() >> 20);
+  if (ImGui::InputInt("Budget (MB)", &budget, 64, 256)) tracker.setBudget(static_cast<size_t>(std::max(0, budget)) << 20);
+
+  ImGui::End();
+}
+
+/////////////////// RENDERER GETTERS //////////////////////
+
+bool Renderer::isLoading(void) const { return this->loader.joinable(); }
\ No newline at end of file
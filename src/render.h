@@ -1,6 +1,11 @@
 #pragma once
 
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <cfloat>
+#include <vector>
+#include <filesystem>
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <imgui.h>
@@ -8,6 +13,13 @@
 #include <backends/imgui_impl_opengl3.h>
 #include <imfilebrowser.h>
 #include "image.h"
+#include "workspace.h"
+#include "gaussian.h"
+#include "median.h"
+#include "bilateral.h"
+#include "profiler.h"
+#include "icon_atlas.h"
+#include "thumbnails.h"
 
 /* Constants */
 const int SCREEN_WIDTH = 1280;
@@ -18,11 +30,27 @@ class Renderer {
 private:
   /* Private Variables */
   ImGui::FileBrowser fileDialog;
-  Image invertIcon;
-  Image grayscaleIcon;
-  Image blurIcon;
-  Image sharpenIcon;
-  Image rotateIcon;
+  ImGui::FileBrowser saveDialog;
+  ImGui::FileBrowser traceDialog;
+  SaveProfile saveProfile;
+  IconAtlas icons;
+  ThumbnailCache thumbnails;
+  std::filesystem::path thumbnailDirectory; // The folder whose files are listed, empty while the file dialog is closed
+  std::vector<std::filesystem::path> thumbnailFiles;
+  std::unique_ptr<Image> pendingImage;
+  std::string pendingPath; // Kept apart from the image, whose path the loader thread writes
+  LoadProgress loadProgress;
+  std::atomic<bool> loadDone;
+  int shownPasses;
+  bool showTimings;
+  bool showMemory;
+  const Image* selectedTab; // The document the tab bar showed last frame
+  std::thread loader;
+
+  /* Private Methods */
+  void startLoading(const std::string path);
+  void cancelLoading(void);
+  void renderThumbnailWindow(void);
 
 public:
   /* Constructor */
@@ -33,7 +61,12 @@ public:
 
   /* Methods */
   void renderMainMenu(GLFWwindow* window, ImGuiIO& io, std::unique_ptr<Image>& image);
-  void renderFileDialog(GLFWwindow* window, std::unique_ptr<Image>& image);
+  void renderFileDialog(GLFWwindow* window, Workspace& workspace);
   void renderControlPanel(GLFWwindow* window, std::unique_ptr<Image>& image);
-  void renderImageEditorWindow(GLFWwindow* window, std::unique_ptr<Image>& image);
+  void renderImageEditorWindow(GLFWwindow* window, Workspace& workspace);
+  void renderTimingsWindow(void);
+  void renderMemoryWindow(void);
+
+  /* Getters */
+  bool isLoading(void) const;
 };
\ No newline at end of file
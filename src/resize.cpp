@@ -0,0 +1,164 @@
+#include <algorithm>
+#include <cmath>
+#include "resize.h"
+#include "filters.h"
+#include "parallel.h"
+#include "memory_tracker.h"
+
+/////////////////// RESIZE HELPERS //////////////////////
+
+// @brief: Returns how far from its center a filter reaches, in source pixels at scale 1
+static double filterRadius(ResizeFilter filter) {
+  switch (filter) {
+    case ResizeFilter::BOX: return 0.5;
+    case ResizeFilter::BILINEAR: return 1.0;
+    case ResizeFilter::BICUBIC: return 2.0;
+    case ResizeFilter::LANCZOS3: return 3.0;
+  }
+  return 1.0;
+}
+
+// @brief: Returns sin(pi x) / (pi x)
+static double sinc(double x) {
+  if (x == 0.0) return 1.0;
+  return std::sin(M_PI * x) / (M_PI * x);
+}
+
+// @brief: Returns the weight of a filter at a distance from its center, at scale 1
+static double filterWeight(ResizeFilter filter, double x) {
+  x = std::fabs(x);
+  switch (filter) {
+    case ResizeFilter::BOX: return x < 0.5 ? 1.0 : 0.0;
+    case ResizeFilter::BILINEAR: return x < 1.0 ? 1.0 - x : 0.0;
+    case ResizeFilter::BICUBIC:
+      if (x < 1.0) return (1.5 * x - 2.5) * x * x + 1.0;
+      if (x < 2.0) return ((-0.5 * x + 2.5) * x - 4.0) * x + 2.0;
+      return 0.0;
+    case ResizeFilter::LANCZOS3: return x < 3.0 ? sinc(x) * sinc(x / 3.0) : 0.0;
+  }
+  return 0.0;
+}
+
+// @brief: Filters a row of floats horizontally into a row of samples
+// Colors of layouts with alpha come in premultiplied by it, and are divided by the filtered alpha again
+// @param `in`: The source row, `channels` floats per source pixel
+// @param `out`: The destination row
+// @param `width`: The number of destination pixels
+// @param `h`: The horizontal taps
+template <typename T, int C>
+static void resizeRow(const float* in, T* out, int width, const ResizeWeights& h) {
+  const float max = SampleTraits<T>::max;
+  constexpr bool alpha = C == 2 || C == 4;
+  for (int x = 0; x < width; ++x) {
+    const float* pixel = in + static_cast<size_t>(h.first[x]) * C;
+    const float* weights = h.weights.data() + static_cast<size_t>(x) * h.taps;
+    float sums[C] = {};
+    for (int k = 0; k < h.taps; ++k) {
+      for (int c = 0; c < C; ++c) sums[c] += weights[k] * pixel[k * C + c];
+    }
+    if (alpha) {
+      // Fully transparent pixels have no color to recover
+      const float scale = sums[C - 1] > 0.0f ? max / sums[C - 1] : 0.0f;
+      for (int c = 0; c < C - 1; ++c) sums[c] *= scale;
+    }
+    for (int c = 0; c < C; ++c) out[x * C + c] = static_cast<T>(std::clamp(sums[c], 0.0f, max) + 0.5f);
+  }
+}
+
+/////////////////// RESIZE WEIGHTS //////////////////////
+
+// @brief: Computes the taps of every output pixel along one axis
+// @param `srcSize`: The number of source pixels
+// @param `dstSize`: The number of output pixels
+// @param `filter`: The filter
+ResizeWeights::ResizeWeights(int srcSize, int dstSize, ResizeFilter filter) {
+  const double scale = static_cast<double>(srcSize) / dstSize;
+  const double stretch = std::max(scale, 1.0);
+  const double support = filterRadius(filter) * stretch;
+
+  // The pixels whose centers fall inside the support, at least the nearest one
+  std::vector<int> lo(dstSize);
+  std::vector<int> hi(dstSize);
+  this->taps = 1;
+  for (int i = 0; i < dstSize; ++i) {
+    const double center = (i + 0.5) * scale;
+    lo[i] = std::clamp(static_cast<int>(std::ceil(center - support - 0.5)), 0, srcSize - 1);
+    hi[i] = std::clamp(static_cast<int>(std::floor(center + support - 0.5)), lo[i], srcSize - 1);
+    this->taps = std::max(this->taps, hi[i] - lo[i] + 1);
+  }
+
+  this->first.resize(dstSize);
+  this->weights.assign(static_cast<size_t>(dstSize) * this->taps, 0.0f);
+  for (int i = 0; i < dstSize; ++i) {
+    const double center = (i + 0.5) * scale;
+    this->first[i] = std::min(lo[i], srcSize - this->taps);
+    float* weights = this->weights.data() + static_cast<size_t>(i) * this->taps;
+    double sum = 0.0;
+    for (int j = lo[i]; j <= hi[i]; ++j) sum += filterWeight(filter, (j + 0.5 - center) / stretch);
+    for (int j = lo[i]; j <= hi[i]; ++j) {
+      const double weight = filterWeight(filter, (j + 0.5 - center) / stretch);
+      weights[j - this->first[i]] = static_cast<float>(sum != 0.0 ? weight / sum : j == lo[i]);
+    }
+  }
+}
+
+/////////////////// IMAGE FILTERS ///////////////////////
+
+// @brief: Resizes an image
+// Each output row sums the source rows under its vertical taps into a row of floats, a multiply-add
+// over whole rows that vectorizes, and then filters that row horizontally. Colors of layouts with alpha
+// are premultiplied by it while they are summed, so transparent pixels do not bleed their color into
+// the edges. Jobs own bands of output rows and need one float row each.
+// @param `src`: The source pixels
+// @param `srcWidth`, `srcHeight`: The source size
+// @param `dst`: The destination pixels
+// @param `dstWidth`, `dstHeight`: The destination size
+// @param `channels`: The number of channels per pixel
+// @param `filter`: The resampling filter
+template <typename T>
+void resizePixels(const T* src, int srcWidth, int srcHeight, T* dst, int dstWidth, int dstHeight, int channels, ResizeFilter filter) {
+  if (srcWidth <= 0 || srcHeight <= 0 || dstWidth <= 0 || dstHeight <= 0) return;
+  const ResizeWeights h(srcWidth, dstWidth, filter);
+  const ResizeWeights v(srcHeight, dstHeight, filter);
+  const size_t srcRow = static_cast<size_t>(srcWidth) * channels;
+  const size_t dstRow = static_cast<size_t>(dstWidth) * channels;
+  const bool alpha = channels == 2 || channels == 4;
+  const float toUnit = 1.0f / SampleTraits<T>::max;
+
+  const size_t bands = (dstHeight + RESIZE_BAND_ROWS - 1) / RESIZE_BAND_ROWS;
+  runJobs(bands, getThreadCount(), [&](size_t band) {
+    const int first = static_cast<int>(band) * RESIZE_BAND_ROWS;
+    const int last = std::min(dstHeight, first + RESIZE_BAND_ROWS);
+    FloatBuffer row(srcRow);
+    for (int y = first; y < last; ++y) {
+      const float* weights = v.weights.data() + static_cast<size_t>(y) * v.taps;
+      std::fill(row.begin(), row.end(), 0.0f);
+      for (int k = 0; k < v.taps; ++k) {
+        if (weights[k] == 0.0f) continue;
+        const T* in = src + (v.first[y] + k) * srcRow;
+        const float weight = weights[k];
+        if (!alpha) {
+          for (size_t i = 0; i < srcRow; ++i) row[i] += weight * in[i];
+          continue;
+        }
+        for (size_t i = 0; i < srcRow; i += channels) {
+          const float coverage = weight * in[i + channels - 1];
+          for (int c = 0; c < channels - 1; ++c) row[i + c] += coverage * toUnit * in[i + c];
+          row[i + channels - 1] += coverage;
+        }
+      }
+      T* out = dst + y * dstRow;
+      switch (channels) {
+        case 1: resizeRow<T, 1>(row.data(), out, dstWidth, h); break;
+        case 2: resizeRow<T, 2>(row.data(), out, dstWidth, h); break;
+        case 3: resizeRow<T, 3>(row.data(), out, dstWidth, h); break;
+        case 4: resizeRow<T, 4>(row.data(), out, dstWidth, h); break;
+      }
+    }
+  });
+}
+
+/////////////////// INSTANTIATIONS //////////////////////
+
+template void resizePixels<png_byte>(const png_byte*, int, int, png_byte*, int, int, int, ResizeFilter);
+template void resizePixels<png_uint_16>(const png_uint_16*, int, int, png_uint_16*, int, int, int, ResizeFilter);
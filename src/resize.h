@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+#include <png.h>
+
+/* Constants */
+const int RESIZE_BAND_ROWS = 16; // Output rows resized by one job
+
+/* Resize Filters */
+enum class ResizeFilter {
+  BOX,      // Average of the covered pixels, nearest neighbour when enlarging
+  BILINEAR, // Triangle
+  BICUBIC,  // Catmull-Rom cubic
+  LANCZOS3  // Windowed sinc with three lobes, the sharpest
+};
+
+/* Resize Weights */
+// The taps of every output pixel along one axis, computed once per resize. Every pixel reads `taps`
+// source pixels from `first[i]` on, with zero weights past its support, so the inner loops have a
+// fixed length. When shrinking, the filter widens by the scale so that every source pixel counts.
+struct ResizeWeights {
+  int taps;
+  std::vector<int> first;
+  std::vector<float> weights; // `taps` weights per output pixel, summing to 1
+
+  ResizeWeights(int srcSize, int dstSize, ResizeFilter filter);
+};
+
+/* Image Filters */
+// Resamples `srcWidth` x `srcHeight` pixels of 1 (G), 2 (GA), 3 (RGB) or 4 (RGBA) channels to `dstWidth` x `dstHeight`
+// with a separable filter, on bands of rows on several threads. Colors are filtered premultiplied by alpha.
+// Instantiated for png_byte (8-bit) and png_uint_16 (16-bit) samples.
+template <typename T> void resizePixels(const T* src, int srcWidth, int srcHeight, T* dst, int dstWidth, int dstHeight, int channels, ResizeFilter filter);
@@ -0,0 +1,283 @@
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include "stream.h"
+#include "encoder.h"
+#include "filters.h"
+#include "mapped_file.h"
+#include "profiler.h"
+
+/////////////////// KERNEL STAGE ////////////////////////
+
+// A row buffer counted as scratch memory, for 8-bit or 16-bit samples
+template <typename T>
+using TrackedBuffer = std::vector<T, TrackedAllocator<T>>;
+
+// A 3x3 kernel applied to a stream of rows with a sliding window of three rows.
+// Every pushed row releases the previous one, so the output lags by one row.
+template <typename T>
+class KernelStage {
+private:
+  const FilterKernel& kernel;
+  int width;
+  int channels;
+  int count;
+  TrackedBuffer<T> window[3];
+  TrackedBuffer<T> out;
+
+public:
+  KernelStage(const FilterKernel& kernel, int width, int channels) : kernel(kernel), width(width), channels(channels), count(0) {
+    for (TrackedBuffer<T>& row : this->window) row.resize(channels * width);
+    this->out.resize(channels * width);
+  }
+
+  // @brief: Pushes a row and returns the previous row once it is complete
+  // @param `row`: The next input row
+  // @return: The finished row, or nullptr while the window is filling
+  T* push(const T* row) {
+    TrackedBuffer<T>& above = this->window[(this->count + 1) % 3];
+    TrackedBuffer<T>& current = this->window[(this->count + 2) % 3];
+    TrackedBuffer<T>& below = this->window[this->count % 3];
+    std::copy(row, row + this->channels * this->width, below.begin());
+
+    T* result = nullptr;
+    if (this->count == 1) {
+      // The first row has no row above and is copied as is
+      std::copy(current.begin(), current.end(), this->out.begin());
+      result = this->out.data();
+    } else if (this->count > 1) {
+      kernelRow(above.data(), current.data(), below.data(), this->out.data(), this->width, this->channels, this->kernel);
+      result = this->out.data();
+    }
+    ++this->count;
+    return result;
+  }
+
+  // @brief: Returns the last row, which has no row below and is copied as is
+  T* flush(void) {
+    if (this->count == 0) return nullptr;
+    TrackedBuffer<T>& last = this->window[(this->count + 2) % 3];
+    std::copy(last.begin(), last.end(), this->out.begin());
+    return this->out.data();
+  }
+};
+
+/////////////////// STREAM CONSTRUCTOR //////////////////
+
+// @brief: Initializes the stream processor
+// @param `pipeline`: The operations applied to the stream
+StreamProcessor::StreamProcessor(const Pipeline& pipeline) : pipeline(pipeline) {
+  this->profile = SaveProfile::BALANCED;
+}
+
+/////////////////// STREAM METHODS //////////////////////
+
+// @brief: Processes an image row by row without holding it in memory
+// Only a few rows are kept at a time, so the memory use is O(width).
+// Rotation, Gaussian blurs and unsharp masks need the whole image at once and are not supported.
+// @param `input`: The path to the input PNG file
+// @param `output`: The path to the output PNG file
+bool StreamProcessor::process(const std::string input, const std::string output) {
+  ScopedTimer timer("Stream");
+  for (const Operation& operation : this->pipeline.getOperations()) {
+    if (operation.isNoOp() || operation.isStreamable()) continue;
+    std::cerr << operation.getName() << " is not supported in streaming mode" << std::endl;
+    return false;
+  }
+
+  // Map the input and open the output
+  MappedFile in;
+  if (!in.open(input)) return false;
+  FILE* out = fopen(output.c_str(), "wb");
+  if (!out) {
+    std::cerr << "Failed to open for writing: " << output << std::endl;
+    return false;
+  }
+  std::unique_ptr<FILE, decltype(&fclose)> outFile(out, fclose);
+
+  // Create a PNG reader and writer
+  png_structp reader = png_create_read_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  png_infop readerInfo = reader ? png_create_info_struct(reader) : nullptr;
+  png_structp writer = png_create_write_struct(PNG_LIBPNG_VER_STRING, nullptr, nullptr, nullptr);
+  png_infop writerInfo = writer ? png_create_info_struct(writer) : nullptr;
+  if (!readerInfo || !writerInfo) {
+    std::cerr << "Failed to create PNG structs" << std::endl;
+    png_destroy_read_struct(&reader, &readerInfo, nullptr);
+    png_destroy_write_struct(&writer, &writerInfo);
+    return false;
+  }
+
+  // Set up error handling
+  if (setjmp(png_jmpbuf(reader))) {
+    std::cerr << "Failed to read PNG data: " << input << std::endl;
+    png_destroy_read_struct(&reader, &readerInfo, nullptr);
+    png_destroy_write_struct(&writer, &writerInfo);
+    return false;
+  }
+  if (setjmp(png_jmpbuf(writer))) {
+    std::cerr << "Failed to write PNG data: " << output << std::endl;
+    png_destroy_read_struct(&reader, &readerInfo, nullptr);
+    png_destroy_write_struct(&writer, &writerInfo);
+    return false;
+  }
+
+  // Read the PNG info
+  in.attach(reader);
+  png_read_info(reader, readerInfo);
+  int width = png_get_image_width(reader, readerInfo);
+  int height = png_get_image_height(reader, readerInfo);
+  int bitDepth = png_get_bit_depth(reader, readerInfo);
+  int colorType = png_get_color_type(reader, readerInfo);
+  if (png_get_interlace_type(reader, readerInfo) != PNG_INTERLACE_NONE) {
+    std::cerr << "Interlaced images cannot be streamed: " << input << std::endl;
+    png_destroy_read_struct(&reader, &readerInfo, nullptr);
+    png_destroy_write_struct(&writer, &writerInfo);
+    return false;
+  }
+
+  // Indexed images without kernel stages keep their indices, and only the palette is edited
+  const std::vector<Operation>& operations = this->pipeline.getOperations();
+  const bool pointOnly = std::all_of(operations.begin(), operations.end(), [](const Operation& operation) { return operation.isNoOp() || operation.isPointOp(); });
+  if (colorType == PNG_COLOR_TYPE_PALETTE && pointOnly) {
+    this->streamIndexed(reader, readerInfo, writer, writerInfo, out);
+    png_destroy_read_struct(&reader, &readerInfo, nullptr);
+    png_destroy_write_struct(&writer, &writerInfo);
+    return true;
+  }
+
+  // Keep the native layout and 16-bit samples in host byte order as in Image::load.
+  // Gray images only become RGB when the gains of an RGB node differ.
+  const png_uint_16 probe = 1;
+  const bool littleEndian = *reinterpret_cast<const png_byte*>(&probe) == 1;
+  const bool tinted = std::any_of(operations.begin(), operations.end(), [](const Operation& operation) {
+    return operation.type == OperationType::RGB && !operation.isNoOp() && (operation.red != operation.green || operation.green != operation.blue);
+  });
+  if (colorType == PNG_COLOR_TYPE_PALETTE) png_set_palette_to_rgb(reader);
+  if (colorType == PNG_COLOR_TYPE_GRAY && bitDepth < 8) png_set_expand_gray_1_2_4_to_8(reader);
+  if (png_get_valid(reader, readerInfo, PNG_INFO_tRNS)) png_set_tRNS_to_alpha(reader);
+  if (!(colorType & PNG_COLOR_MASK_COLOR) && tinted) png_set_gray_to_rgb(reader);
+  if (bitDepth == 16 && littleEndian) png_set_swap(reader);
+  png_read_update_info(reader, readerInfo);
+  bitDepth = png_get_bit_depth(reader, readerInfo);
+  colorType = png_get_color_type(reader, readerInfo);
+  int channels = png_get_channels(reader, readerInfo);
+
+  // Write the PNG info
+  int level, memLevel, strategy;
+  bool adaptive;
+  Encoder::getProfileParameters(this->profile, level, memLevel, strategy, adaptive);
+  png_init_io(writer, out);
+  png_set_IHDR(writer, writerInfo, width, height, bitDepth, colorType, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  png_set_compression_level(writer, level);
+  png_set_compression_mem_level(writer, memLevel);
+  png_set_compression_strategy(writer, strategy);
+  png_set_filter(writer, PNG_FILTER_TYPE_BASE, adaptive ? PNG_ALL_FILTERS : PNG_FILTER_SUB);
+  png_write_info(writer, writerInfo);
+  if (bitDepth == 16 && littleEndian) png_set_swap(writer);
+
+  // Stream the rows
+  if (bitDepth == 16) this->streamRows<png_uint_16>(reader, writer, width, height, channels);
+  else this->streamRows<png_byte>(reader, writer, width, height, channels);
+
+  // Cleanup
+  png_read_end(reader, nullptr);
+  png_write_end(writer, nullptr);
+  png_destroy_read_struct(&reader, &readerInfo, nullptr);
+  png_destroy_write_struct(&writer, &writerInfo);
+
+  return true;
+}
+
+// @brief: Runs every row of the image through the pipeline
+// @param `reader`: The PNG read struct, positioned at the first row
+// @param `writer`: The PNG write struct, positioned at the first row
+// @param `width`, `height`: The image size
+// @param `channels`: The number of channels per pixel
+template <typename T>
+void StreamProcessor::streamRows(png_structp reader, png_structp writer, int width, int height, int channels) {
+  // Build a stage for every node that changes the image, in pipeline order
+  struct Stage {
+    const Operation* operation;
+    std::unique_ptr<KernelStage<T>> kernel; // Set for kernel nodes, which hold back one row
+  };
+  std::vector<Stage> stages;
+  for (const Operation& operation : this->pipeline.getOperations()) {
+    if (operation.isNoOp()) continue;
+    Stage stage = { &operation, nullptr };
+    if (operation.type == OperationType::BLUR) stage.kernel = std::make_unique<KernelStage<T>>(BLUR_KERNEL, width, channels);
+    if (operation.type == OperationType::SHARPEN) stage.kernel = std::make_unique<KernelStage<T>>(SHARPEN_KERNEL, width, channels);
+    stages.push_back(std::move(stage));
+  }
+
+  // Runs a row through the stages from `first` on and writes it out once it leaves the last one
+  auto emit = [&](T* row, size_t first) {
+    for (size_t s = first; s < stages.size() && row; ++s) {
+      const Operation& operation = *stages[s].operation;
+      if (stages[s].kernel) row = stages[s].kernel->push(row);
+      else if (operation.type == OperationType::INVERT) invertRow(row, width, channels);
+      else if (operation.type == OperationType::GRAYSCALE) grayscaleRow(row, width, channels);
+      else if (operation.type == OperationType::RGB) rgbRow(row, width, channels, operation.red, operation.green, operation.blue);
+    }
+    if (!row) return;
+    png_write_row(writer, reinterpret_cast<png_bytep>(row));
+  };
+
+  // Stream the rows through the stages
+  TrackedBuffer<T> row(channels * width);
+  for (int y = 0; y < height; ++y) {
+    png_read_row(reader, reinterpret_cast<png_bytep>(row.data()), nullptr);
+    emit(row.data(), 0);
+  }
+
+  // Drain the rows still held by the kernel stages
+  for (size_t s = 0; s < stages.size(); ++s) {
+    if (stages[s].kernel) emit(stages[s].kernel->flush(), s + 1);
+  }
+}
+
+// @brief: Copies the rows of an indexed image as they are and writes an edited palette
+// @param `reader`, `readerInfo`: The PNG reader, after the header has been read
+// @param `writer`, `writerInfo`: The PNG writer, before the header has been written
+// @param `out`: The output file
+void StreamProcessor::streamIndexed(png_structp reader, png_infop readerInfo, png_structp writer, png_infop writerInfo, FILE* out) {
+  png_colorp entries = nullptr;
+  int count = 0;
+  png_get_PLTE(reader, readerInfo, &entries, &count);
+  std::vector<png_color> palette(entries, entries + count);
+  for (const Operation& operation : this->pipeline.getOperations()) {
+    if (operation.isNoOp()) continue;
+    if (operation.type == OperationType::INVERT) invertPalette(palette.data(), count);
+    if (operation.type == OperationType::GRAYSCALE) grayscalePalette(palette.data(), count);
+    if (operation.type == OperationType::RGB) rgbPalette(palette.data(), count, operation.red, operation.green, operation.blue);
+  }
+
+  // Write the PNG info with the same bit depth and transparency
+  int level, memLevel, strategy;
+  bool adaptive;
+  Encoder::getProfileParameters(this->profile, level, memLevel, strategy, adaptive);
+  png_init_io(writer, out);
+  png_set_IHDR(writer, writerInfo, png_get_image_width(reader, readerInfo), png_get_image_height(reader, readerInfo), png_get_bit_depth(reader, readerInfo),
+               PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  png_set_PLTE(writer, writerInfo, palette.data(), count);
+  png_bytep alpha = nullptr;
+  int alphaCount = 0;
+  if (png_get_tRNS(reader, readerInfo, &alpha, &alphaCount, nullptr) && alpha) png_set_tRNS(writer, writerInfo, alpha, alphaCount, nullptr);
+  png_set_compression_level(writer, level);
+  png_set_compression_mem_level(writer, memLevel);
+  png_set_compression_strategy(writer, strategy);
+  png_set_filter(writer, PNG_FILTER_TYPE_BASE, adaptive ? PNG_ALL_FILTERS : PNG_FILTER_SUB);
+  png_write_info(writer, writerInfo);
+
+  // Copy the packed rows
+  PixelBuffer row(png_get_rowbytes(reader, readerInfo));
+  for (png_uint_32 y = 0; y < png_get_image_height(reader, readerInfo); ++y) {
+    png_read_row(reader, row.data(), nullptr);
+    png_write_row(writer, row.data());
+  }
+  png_read_end(reader, nullptr);
+  png_write_end(writer, nullptr);
+}
+
+/////////////////// STREAM SETTERS //////////////////////
+
+void StreamProcessor::setProfile(SaveProfile profile) { this->profile = profile; }
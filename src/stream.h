@@ -0,0 +1,28 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <png.h>
+#include "image.h"
+#include "pipeline.h"
+
+class StreamProcessor {
+private:
+  /* Private Variables */
+  const Pipeline& pipeline;
+  SaveProfile profile;
+
+  /* Private Methods */
+  template <typename T> void streamRows(png_structp reader, png_structp writer, int width, int height, int channels);
+  void streamIndexed(png_structp reader, png_infop readerInfo, png_structp writer, png_infop writerInfo, FILE* out);
+
+public:
+  /* Constructor */
+  StreamProcessor(const Pipeline& pipeline);
+
+  /* Methods */
+  bool process(const std::string input, const std::string output);
+
+  /* Setters */
+  void setProfile(SaveProfile profile);
+};
@@ -0,0 +1,343 @@
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <glad/glad.h>
+#include <png.h>
+#include "thumbnails.h"
+#include "resize.h"
+#include "parallel.h"
+#include "hash.h"
+#include "file_key.h"
+
+/////////////////// THUMBNAIL HELPERS ///////////////////
+
+// @brief: Returns the directory that holds cached thumbnails, creating it if needed
+// @return: The directory, or an empty path when none can be created
+static std::filesystem::path findCacheDirectory(void) {
+  std::filesystem::path root;
+  if (const char* cache = std::getenv("XDG_CACHE_HOME")) root = std::filesystem::path(cache) / "tap";
+  else if (const char* local = std::getenv("LOCALAPPDATA")) root = std::filesystem::path(local) / "TAP";
+  else if (const char* home = std::getenv("HOME")) root = std::filesystem::path(home) / ".cache" / "tap";
+  else {
+    std::error_code error;
+    root = std::filesystem::temp_directory_path(error) / "tap";
+    if (error) return std::filesystem::path();
+  }
+
+  std::error_code error;
+  std::filesystem::path directory = root / "thumbnails";
+  std::filesystem::create_directories(directory, error);
+  if (error) {
+    std::cerr << "Failed to create thumbnail cache: " << directory.string() << std::endl;
+    return std::filesystem::path();
+  }
+  return directory;
+}
+
+// @brief: Reads a cached thumbnail
+// @return: Whether the file held a thumbnail
+static bool readThumbnail(const std::filesystem::path& path, int& width, int& height, PixelBuffer& pixels) {
+  png_image image = {};
+  image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_file(&image, path.string().c_str())) return false;
+  if (image.width == 0 || image.height == 0 || image.width > THUMBNAIL_SIZE || image.height > THUMBNAIL_SIZE) {
+    png_image_free(&image);
+    return false;
+  }
+  image.format = PNG_FORMAT_RGBA;
+  width = static_cast<int>(image.width);
+  height = static_cast<int>(image.height);
+  pixels.resize(PNG_IMAGE_SIZE(image));
+  if (!png_image_finish_read(&image, nullptr, pixels.data(), 0, nullptr)) {
+    png_image_free(&image);
+    return false;
+  }
+  return true;
+}
+
+// @brief: Writes a thumbnail to the cache
+// The file is written under a name of its own and renamed into place, so that a reader never sees half of it
+static void writeThumbnail(const std::filesystem::path& path, int width, int height, const PixelBuffer& pixels) {
+  png_image image = {};
+  image.version = PNG_IMAGE_VERSION;
+  image.width = width;
+  image.height = height;
+  image.format = PNG_FORMAT_RGBA;
+  std::filesystem::path temporary = path;
+  temporary += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+  if (!png_image_write_to_file(&image, temporary.string().c_str(), 0, pixels.data(), 0, nullptr)) {
+    std::cerr << "Failed to write thumbnail: " << temporary.string() << " (" << image.message << ")" << std::endl;
+    return;
+  }
+
+  std::error_code error;
+  std::filesystem::rename(temporary, path, error);
+  if (error) std::filesystem::remove(temporary, error);
+}
+
+/////////////////// THUMBNAIL CACHE CONSTRUCTOR /////////
+
+// @brief: Starts the decoding threads
+ThumbnailCache::ThumbnailCache(void) {
+  this->directory = findCacheDirectory();
+  this->frame = 0;
+  this->textures = 0;
+  this->stopping = false;
+  const int workers = std::clamp(getThreadCount() - 1, 1, THUMBNAIL_MAX_WORKERS);
+  this->workers.emplace_back([this]() {
+    this->prune();
+    this->work();
+  });
+  for (int i = 1; i < workers; ++i) this->workers.emplace_back([this]() { this->work(); });
+}
+
+/////////////////// THUMBNAIL CACHE DESTRUCTOR //////////
+
+// @brief: Stops the decoding threads and deallocates the textures
+// Files being decoded are finished first; queued ones are dropped
+ThumbnailCache::~ThumbnailCache(void) {
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    this->stopping = true;
+    this->queue.clear();
+  }
+  this->wake.notify_all();
+  for (std::thread& worker : this->workers) worker.join();
+  for (auto& [path, entry] : this->entries) this->releaseTexture(entry);
+}
+
+/////////////////// THUMBNAIL CACHE PRIVATE METHODS /////
+
+// @brief: Builds the thumbnails of queued files until the cache is destroyed
+void ThumbnailCache::work(void) {
+  std::unique_lock<std::mutex> guard(this->lock);
+  while (true) {
+    this->wake.wait(guard, [this]() { return this->stopping || !this->queue.empty(); });
+    if (this->stopping) return;
+    std::string path = std::move(this->queue.back());
+    this->queue.pop_back();
+    auto found = this->entries.find(path);
+    if (found == this->entries.end() || found->second.state != State::QUEUED) continue;
+    found->second.state = State::DECODING;
+
+    guard.unlock();
+    int width = 0;
+    int height = 0;
+    PixelBuffer pixels(MemoryCategory::CACHE);
+    bool built = this->build(path, width, height, pixels);
+    guard.lock();
+
+    // The entry stays while it is decoding, since only queued entries are cancelled
+    Entry& entry = this->entries[path];
+    entry.state = built ? State::READY : State::FAILED;
+    entry.finished = this->frame;
+    entry.width = width;
+    entry.height = height;
+    entry.pixels = std::move(pixels);
+  }
+}
+
+// @brief: Deletes the least recently used cached thumbnails while the cache is larger than THUMBNAIL_CACHE_BYTES
+// Reading a cached thumbnail touches its file, so the modification times order the files by use.
+// Temporary files left behind by a crash are the oldest too, and go the same way.
+void ThumbnailCache::prune(void) const {
+  if (this->directory.empty()) return;
+  std::vector<std::pair<std::filesystem::file_time_type, std::filesystem::path>> files;
+  uintmax_t total = 0;
+  std::error_code error;
+  for (const std::filesystem::directory_entry& file : std::filesystem::directory_iterator(this->directory, error)) {
+    if (!file.is_regular_file(error)) continue;
+    const uintmax_t size = file.file_size(error);
+    if (error) continue;
+    const std::filesystem::file_time_type modified = file.last_write_time(error);
+    if (error) continue;
+    total += size;
+    files.emplace_back(modified, file.path());
+  }
+  if (total <= THUMBNAIL_CACHE_BYTES) return;
+
+  std::sort(files.begin(), files.end());
+  for (const auto& [modified, path] : files) {
+    if (total <= THUMBNAIL_CACHE_BYTES) break;
+    const uintmax_t size = std::filesystem::file_size(path, error);
+    if (error) continue;
+    if (std::filesystem::remove(path, error)) total -= size;
+  }
+}
+
+// @brief: Reads the thumbnail of a file from the cache, or decodes and downscales the file and caches the result
+// @param `path`: The path to the PNG file
+// @param `width`, `height`: Set to the size of the thumbnail
+// @param `pixels`: Set to the 8-bit RGBA pixels of the thumbnail
+// @return: Whether a thumbnail was made
+bool ThumbnailCache::build(const std::string& path, int& width, int& height, PixelBuffer& pixels) const {
+  TraceScope scope("Thumbnail");
+  const std::filesystem::path cachePath = this->getCachePath(path);
+  if (!cachePath.empty() && readThumbnail(cachePath, width, height, pixels)) {
+    std::error_code error;
+    std::filesystem::last_write_time(cachePath, std::filesystem::file_time_type::clock::now(), error);
+    return true;
+  }
+
+  png_image image = {};
+  image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_file(&image, path.c_str())) return false;
+  image.format = PNG_FORMAT_RGBA;
+  const int srcWidth = static_cast<int>(image.width);
+  const int srcHeight = static_cast<int>(image.height);
+  const size_t bytes = static_cast<size_t>(srcWidth) * srcHeight * 4; // PNG_IMAGE_SIZE overflows past 4 GB
+  if (!MemoryTracker::get().fits(bytes)) {
+    png_image_free(&image);
+    return false;
+  }
+  PixelBuffer full(bytes);
+  if (!png_image_finish_read(&image, nullptr, full.data(), 0, nullptr)) {
+    png_image_free(&image);
+    return false;
+  }
+
+  // Fit the longest side, averaging every source pixel under each thumbnail pixel
+  const double scale = std::min(1.0, static_cast<double>(THUMBNAIL_SIZE) / std::max(srcWidth, srcHeight));
+  width = std::max(1, static_cast<int>(srcWidth * scale + 0.5));
+  height = std::max(1, static_cast<int>(srcHeight * scale + 0.5));
+  pixels.resize(static_cast<size_t>(width) * height * 4);
+  resizePixels<png_byte>(full.data(), srcWidth, srcHeight, pixels.data(), width, height, 4, ResizeFilter::BOX);
+  if (!cachePath.empty()) writeThumbnail(cachePath, width, height, pixels);
+  return true;
+}
+
+// @brief: Returns where the thumbnail of a file is cached
+// The name hashes the key of the file, so an edited file gets a new thumbnail
+// @param `path`: The path to the PNG file
+// @return: The path of the cached thumbnail, or an empty path when the file cannot be examined
+std::filesystem::path ThumbnailCache::getCachePath(const std::string& path) const {
+  if (this->directory.empty()) return std::filesystem::path();
+  const std::string key = getFileKey(path);
+  if (key.empty()) return std::filesystem::path();
+
+  const uint64_t hash = mixHash(HASH_SEED, key.data(), key.size());
+  char name[32];
+  std::snprintf(name, sizeof(name), "%016llx.png", static_cast<unsigned long long>(hash));
+  return this->directory / name;
+}
+
+// @brief: Deallocates the texture of an entry
+void ThumbnailCache::releaseTexture(Entry& entry) {
+  if (!entry.texture) return;
+  GLuint textureID = (GLuint)(intptr_t)entry.texture;
+  glDeleteTextures(1, &textureID);
+  MemoryTracker::get().remove(MemoryCategory::TEXTURE, static_cast<size_t>(entry.width) * entry.height * 4);
+  entry.texture = nullptr;
+  --this->textures;
+}
+
+// @brief: Forgets the least recently drawn thumbnails while there are too many textures, and files that failed a while ago
+// Thumbnails are read back from the disk cache when they are drawn again. Failed files are decoded again if
+// they are still drawn, since they may have been incomplete or the memory budget may have been short.
+void ThumbnailCache::evict(void) {
+  for (auto it = this->entries.begin(); it != this->entries.end();) {
+    if (it->second.state == State::FAILED && this->frame - it->second.finished > THUMBNAIL_RETRY_FRAMES) it = this->entries.erase(it);
+    else ++it;
+  }
+
+  if (this->textures <= THUMBNAIL_MAX_TEXTURES) return;
+  std::vector<std::pair<uint64_t, std::string>> uploaded;
+  for (const auto& [path, entry] : this->entries) {
+    if (entry.state == State::UPLOADED) uploaded.emplace_back(entry.lastUsed, path);
+  }
+  const size_t excess = this->textures - THUMBNAIL_MAX_TEXTURES;
+  std::nth_element(uploaded.begin(), uploaded.begin() + excess, uploaded.end());
+  for (size_t i = 0; i < excess; ++i) {
+    auto found = this->entries.find(uploaded[i].second);
+    this->releaseTexture(found->second);
+    this->entries.erase(found);
+  }
+}
+
+/////////////////// THUMBNAIL CACHE METHODS /////////////
+
+// @brief: Returns the texture of a file's thumbnail, queueing the file when it has none yet
+// @param `path`: The path to the PNG file
+// @param `size`: Set to the size of the thumbnail, or to a square of THUMBNAIL_SIZE while there is none
+// @return: The texture, or nullptr while the thumbnail is being made or when the file could not be decoded
+ImTextureID ThumbnailCache::request(const std::string& path, ImVec2& size) {
+  size = ImVec2(THUMBNAIL_SIZE, THUMBNAIL_SIZE);
+  std::lock_guard<std::mutex> guard(this->lock);
+  auto [found, inserted] = this->entries.try_emplace(path);
+  Entry& entry = found->second;
+  entry.lastUsed = this->frame;
+  if (inserted) {
+    this->queue.push_back(path);
+    this->wake.notify_one();
+  }
+  if (entry.state != State::UPLOADED) return nullptr;
+  size = ImVec2(static_cast<float>(entry.width), static_cast<float>(entry.height));
+  return entry.texture;
+}
+
+// @brief: Creates the textures of finished thumbnails, a few per frame, and releases the least recently drawn
+// The pixels are taken out under the lock and the textures created outside it, so the workers are not held up.
+// Must be called once per frame on the thread that owns the OpenGL context
+void ThumbnailCache::upload(void) {
+  struct Upload {
+    std::string path;
+    int width;
+    int height;
+    PixelBuffer pixels;
+    GLuint textureID;
+  };
+  std::vector<Upload> uploads;
+  {
+    std::lock_guard<std::mutex> guard(this->lock);
+    ++this->frame;
+    for (auto& [path, entry] : this->entries) {
+      if (uploads.size() == THUMBNAIL_UPLOADS_PER_FRAME) break;
+      if (entry.state != State::READY) continue;
+      entry.state = State::UPLOADING;
+      uploads.push_back({ path, entry.width, entry.height, std::move(entry.pixels), 0 });
+    }
+  }
+
+  for (Upload& upload : uploads) {
+    glGenTextures(1, &upload.textureID);
+    if (!upload.textureID) {
+      std::cerr << "Failed to create OpenGL texture" << std::endl;
+      break;
+    }
+    glBindTexture(GL_TEXTURE_2D, upload.textureID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, upload.width, upload.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, upload.pixels.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  }
+
+  std::lock_guard<std::mutex> guard(this->lock);
+  for (Upload& upload : uploads) {
+    // Entries are not dropped while they are uploading, so the entry is still there
+    Entry& entry = this->entries.at(upload.path);
+    if (!upload.textureID) {
+      // Tried again next frame
+      entry.state = State::READY;
+      entry.pixels = std::move(upload.pixels);
+      continue;
+    }
+    MemoryTracker::get().add(MemoryCategory::TEXTURE, static_cast<size_t>(upload.width) * upload.height * 4);
+    entry.texture = reinterpret_cast<ImTextureID>(static_cast<intptr_t>(upload.textureID));
+    entry.state = State::UPLOADED;
+    ++this->textures;
+  }
+  this->evict();
+}
+
+// @brief: Drops the files that are still waiting to be decoded, e.g. when the browser leaves their folder
+// Files that failed are dropped as well, so they are tried again when their folder is shown again
+void ThumbnailCache::cancel(void) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  for (auto it = this->entries.begin(); it != this->entries.end();) {
+    if (it->second.state == State::QUEUED || it->second.state == State::FAILED) it = this->entries.erase(it);
+    else ++it;
+  }
+  this->queue.clear();
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <filesystem>
+#include <cstdint>
+#include <imgui.h>
+#include "memory_tracker.h"
+
+/* Constants */
+const int THUMBNAIL_SIZE = 96;                     // Longest side of a thumbnail in pixels
+const int THUMBNAIL_MAX_WORKERS = 4;               // Decoding threads, at most one less than the cores
+const int THUMBNAIL_UPLOADS_PER_FRAME = 32;        // Textures created per frame, so that a full folder does not stall one frame
+const size_t THUMBNAIL_MAX_TEXTURES = 512;         // Textures kept alive; the least recently drawn are released past this
+const uintmax_t THUMBNAIL_CACHE_BYTES = 128 << 20; // Disk cache size; the least recently used files are deleted past this
+const uint64_t THUMBNAIL_RETRY_FRAMES = 600;       // Frames after which a file that failed is forgotten, and tried again if drawn
+
+// Thumbnails of PNG files, decoded and downscaled on background threads and kept on disk under
+// the user cache directory, keyed by the path, modification time and size of each file, so that
+// reopening a folder only reads the small cached files. The disk cache is trimmed to
+// THUMBNAIL_CACHE_BYTES at startup, least recently used first. Textures are created on the UI thread.
+class ThumbnailCache {
+private:
+  /* Private Types */
+  enum class State { QUEUED, DECODING, READY, FAILED, UPLOADING, UPLOADED };
+  struct Entry {
+    State state = State::QUEUED;
+    int width = 0;
+    int height = 0;
+    PixelBuffer pixels = PixelBuffer(MemoryCategory::CACHE); // 8-bit RGBA, until it is uploaded
+    ImTextureID texture = nullptr;
+    uint64_t lastUsed = 0; // Frame in which the thumbnail was last requested
+    uint64_t finished = 0; // Frame in which decoding finished
+  };
+
+  /* Private Variables */
+  std::filesystem::path directory; // Empty when there is nowhere to write the cache
+  std::unordered_map<std::string, Entry> entries;
+  std::vector<std::string> queue; // Taken from the back, so the latest requests, the ones on screen, go first
+  std::mutex lock;
+  std::condition_variable wake;
+  std::vector<std::thread> workers;
+  uint64_t frame;
+  size_t textures;
+  bool stopping;
+
+  /* Private Methods */
+  void work(void);
+  void prune(void) const;
+  bool build(const std::string& path, int& width, int& height, PixelBuffer& pixels) const;
+  std::filesystem::path getCachePath(const std::string& path) const;
+  void releaseTexture(Entry& entry);
+  void evict(void);
+
+public:
+  /* Constructor */
+  ThumbnailCache(void);
+
+  /* Destructor */
+  ~ThumbnailCache(void);
+
+  /* Methods */
+  ImTextureID request(const std::string& path, ImVec2& size);
+  void upload(void);
+  void cancel(void);
+};
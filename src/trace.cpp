@@ -0,0 +1,137 @@
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include "trace.h"
+
+thread_local Tracer::LaneOwner Tracer::owner;
+
+/////////////////// TRACER CONSTRUCTOR //////////////////
+
+// @brief: Initializes a tracer without lanes
+Tracer::Tracer(void) {
+  this->threads = 0;
+  this->start = std::chrono::steady_clock::now();
+}
+
+/////////////////// TRACER PRIVATE METHODS //////////////
+
+// @brief: Gives the calling thread a lane and a new id, reusing a lane whose thread has exited
+Tracer::Lane* Tracer::acquireLane(void) {
+  std::lock_guard<std::mutex> guard(this->lock);
+  const int thread = ++this->threads;
+  for (std::unique_ptr<Lane>& lane : this->lanes) {
+    if (lane->owned) continue;
+    lane->thread = thread;
+    lane->owned = true;
+    return lane.get();
+  }
+  std::unique_ptr<Lane> lane = std::make_unique<Lane>();
+  lane->thread = thread;
+  lane->events = std::make_unique<Slot[]>(TRACE_LANE_EVENTS);
+  lane->written = 0;
+  lane->owned = true;
+  this->lanes.push_back(std::move(lane));
+  return this->lanes.back().get();
+}
+
+// @brief: Releases the lane of an exiting thread; its events stay until they are overwritten
+Tracer::LaneOwner::~LaneOwner(void) {
+  if (!this->lane) return;
+  std::lock_guard<std::mutex> guard(Tracer::get().lock);
+  this->lane->owned = false;
+}
+
+/////////////////// TRACER METHODS //////////////////////
+
+// @brief: Returns the tracer shared by the whole program
+Tracer& Tracer::get(void) {
+  static Tracer tracer;
+  return tracer;
+}
+
+// @brief: Appends an event to the calling thread's lane
+// Only the owning thread writes to a lane, so this takes no lock; the count is published
+// after the event so that a concurrent write sees whole events.
+// @param `name`: The scope, which must outlive the tracer
+// @param `phase`: 'B' at the start of the scope, 'E' at its end
+void Tracer::record(const char* name, char phase) {
+  if (!owner.lane) owner.lane = this->acquireLane();
+  Lane* lane = owner.lane;
+  const uint64_t index = lane->written.load(std::memory_order_relaxed);
+  const uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - this->start).count();
+  Slot& slot = lane->events[index % TRACE_LANE_EVENTS];
+  slot.name.store(name, std::memory_order_relaxed);
+  slot.time.store(time, std::memory_order_relaxed);
+  slot.phase.store(phase, std::memory_order_relaxed);
+  slot.thread.store(lane->thread, std::memory_order_relaxed);
+  lane->written.store(index + 1, std::memory_order_release);
+}
+
+// @brief: Writes the events of every lane as Chrome trace-event JSON, which Perfetto also reads
+// Threads may keep recording; events they overwrite while the lanes are copied are dropped, and so is
+// the oldest one left, whose slot the next event may be filling during the copy.
+// @param `path`: The output file
+// @return: Whether the trace was written
+bool Tracer::write(const std::string& path) {
+#if !TAP_TRACE
+  std::cerr << "Tracing is disabled in this build" << std::endl;
+  return false;
+#endif
+  std::ofstream file(path);
+  if (!file) {
+    std::cerr << "Failed to open trace file: " << path << std::endl;
+    return false;
+  }
+
+  std::lock_guard<std::mutex> guard(this->lock);
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (const std::unique_ptr<Lane>& lane : this->lanes) {
+    const uint64_t before = lane->written.load(std::memory_order_acquire);
+    std::vector<TraceEvent> events(TRACE_LANE_EVENTS);
+    for (size_t i = 0; i < TRACE_LANE_EVENTS; ++i) {
+      const Slot& slot = lane->events[i];
+      events[i] = { slot.name.load(std::memory_order_relaxed), slot.time.load(std::memory_order_relaxed), slot.phase.load(std::memory_order_relaxed),
+                    slot.thread.load(std::memory_order_relaxed) };
+    }
+    const uint64_t after = lane->written.load(std::memory_order_acquire);
+    const uint64_t oldest = after >= TRACE_LANE_EVENTS ? after - TRACE_LANE_EVENTS + 1 : 0;
+
+    // Ends whose begin was overwritten would close scopes they do not belong to
+    int depth = 0;
+    int thread = 0;
+    for (uint64_t i = oldest; i < before; ++i) {
+      const TraceEvent& event = events[i % TRACE_LANE_EVENTS];
+      if (event.thread != thread) {
+        thread = event.thread;
+        depth = 0;
+      }
+      if (event.phase == 'E' && depth == 0) continue;
+      depth += event.phase == 'B' ? 1 : -1;
+      file << (first ? "" : ",") << "\n{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase << "\",\"ts\":" << std::fixed << std::setprecision(3)
+           << event.time / 1000.0 << ",\"pid\":1,\"tid\":" << event.thread << "}";
+      first = false;
+    }
+  }
+  file << "\n]}\n";
+  if (!file) {
+    std::cerr << "Failed to write trace file: " << path << std::endl;
+    return false;
+  }
+  return true;
+}
+
+/////////////////// TRACE SCOPE /////////////////////////
+
+#if TAP_TRACE
+// @brief: Records the begin of a scope and, once it goes out of scope, its end
+// @param `name`: The scope, which must outlive the tracer
+TraceScope::TraceScope(const char* name) {
+  this->name = name;
+  Tracer::get().record(name, 'B');
+}
+
+TraceScope::~TraceScope(void) {
+  Tracer::get().record(this->name, 'E');
+}
+#endif
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <chrono>
+#include <cstdint>
+
+// Tracing is compiled in unless the build sets TAP_TRACE to 0
+#ifndef TAP_TRACE
+#define TAP_TRACE 1
+#endif
+
+/* Constants */
+const size_t TRACE_LANE_EVENTS = 1 << 14; // Events kept per thread; older ones are overwritten
+
+/* Trace Event */
+// The begin or end of a scope on one thread
+struct TraceEvent {
+  const char* name;
+  uint64_t time; // Nanoseconds since the tracer started
+  char phase;    // 'B' or 'E', as in the Chrome trace format
+  int thread;    // Id of the recording thread, as the trace shows it
+};
+
+class Tracer {
+private:
+  /* Private Types */
+  // One event of a lane; its fields are atomic since a trace may be written while the owner records
+  struct Slot {
+    std::atomic<const char*> name;
+    std::atomic<uint64_t> time;
+    std::atomic<char> phase;
+    std::atomic<int> thread;
+  };
+
+  // A ring of events owned by one thread at a time, reused once that thread exits
+  struct Lane {
+    int thread; // Id of the owning thread; every thread gets a new one, even in a reused lane
+    std::unique_ptr<Slot[]> events;
+    std::atomic<uint64_t> written; // Events written so far; the newest TRACE_LANE_EVENTS are in the ring
+    bool owned;
+  };
+
+  // Gives a lane back when its thread exits
+  struct LaneOwner {
+    Lane* lane = nullptr;
+    ~LaneOwner(void);
+  };
+
+  /* Private Variables */
+  std::vector<std::unique_ptr<Lane>> lanes;
+  int threads; // Threads that have recorded so far
+  std::mutex lock; // Taken when a thread first records and when a trace is written, never per event
+  std::chrono::steady_clock::time_point start;
+  static thread_local LaneOwner owner;
+
+  /* Private Methods */
+  Lane* acquireLane(void);
+
+public:
+  /* Constructor */
+  Tracer(void);
+
+  /* Methods */
+  static Tracer& get(void);
+  void record(const char* name, char phase);
+  bool write(const std::string& path);
+};
+
+class TraceScope {
+public:
+#if TAP_TRACE
+  /* Constructor */
+  TraceScope(const char* name);
+
+  /* Destructor */
+  ~TraceScope(void);
+
+private:
+  /* Private Variables */
+  const char* name;
+#else
+  TraceScope(const char*) {}
+#endif
+};
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include "workspace.h"
+#include "memory_tracker.h"
+
+/////////////////// WORKSPACE HELPERS ///////////////////
+
+// @brief: Returns whether less than a quarter of the memory budget is left, if there is a budget
+static bool isBudgetLow(void) {
+  const size_t budget = MemoryTracker::get().getBudget();
+  return budget > 0 && MemoryTracker::get().getTotal() > budget - budget / 4;
+}
+
+/////////////////// WORKSPACE CONSTRUCTOR ///////////////
+
+// @brief: Initializes a workspace without documents
+Workspace::Workspace(void) {
+  this->blank = std::make_unique<Image>();
+  this->active = 0;
+  this->clock = 0;
+}
+
+/////////////////// WORKSPACE METHODS ///////////////////
+
+// @brief: Adds a loaded image in a new tab and makes it active
+// @param `image`: The image
+void Workspace::open(std::unique_ptr<Image> image) {
+  this->documents.push_back(std::move(image));
+  this->lastShown.push_back(0);
+  this->activate(this->documents.size() - 1);
+}
+
+// @brief: Closes a document, making its neighbour active if it was active
+// The memory it gives back may let an active document that did not fit be computed again
+// @param `index`: The index of the document
+void Workspace::close(size_t index) {
+  if (index >= this->documents.size()) return;
+  this->documents.erase(this->documents.begin() + index);
+  this->lastShown.erase(this->lastShown.begin() + index);
+  if (this->documents.empty()) {
+    this->active = 0;
+    return;
+  }
+  if (index == this->active) {
+    this->activate(std::min(index, this->documents.size() - 1));
+    return;
+  }
+  if (index < this->active) --this->active;
+  this->documents[this->active]->restoreData();
+}
+
+// @brief: Makes a document active, computing its edited pixels again if they were released
+// The others are trimmed first, so that the memory they give up is there for it. A document that still
+// does not fit stays active without its pixels; the editor shows the error and refuses to save or edit it.
+// @param `index`: The index of the document
+// @return: Whether the document has its edited pixels
+bool Workspace::activate(size_t index) {
+  if (index >= this->documents.size()) return false;
+  this->active = index;
+  this->lastShown[index] = ++this->clock;
+  this->trim();
+  return this->documents[index]->restoreData();
+}
+
+// @brief: Releases what background documents hold
+// Textures go right away, since the active one is uploaded again in one call when a tab is shown;
+// edited pixels only go when they take too much memory, since they can take longer to compute.
+void Workspace::trim(void) {
+  size_t background = 0;
+  for (size_t i = 0; i < this->documents.size(); ++i) {
+    if (i == this->active) continue;
+    this->documents[i]->releaseOpenGLTexture();
+    background += this->documents[i]->getResidentBytes();
+  }
+
+  while (background > WORKSPACE_BACKGROUND_BYTES || (background > 0 && isBudgetLow())) {
+    size_t oldest = this->documents.size();
+    for (size_t i = 0; i < this->documents.size(); ++i) {
+      if (i == this->active || this->documents[i]->getResidentBytes() == 0) continue;
+      if (oldest == this->documents.size() || this->lastShown[i] < this->lastShown[oldest]) oldest = i;
+    }
+    background -= this->documents[oldest]->getResidentBytes();
+    this->documents[oldest]->releaseData();
+  }
+}
+
+/////////////////// WORKSPACE GETTERS ///////////////////
+
+std::unique_ptr<Image>& Workspace::getActive(void) { return this->documents.empty() ? this->blank : this->documents[this->active]; }
+size_t Workspace::getActiveIndex(void) const { return this->active; }
+std::unique_ptr<Image>& Workspace::getDocument(size_t index) { return this->documents[index]; }
+size_t Workspace::size(void) const { return this->documents.size(); }
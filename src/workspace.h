@@ -0,0 +1,39 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+#include "image.h"
+
+/* Constants */
+const size_t WORKSPACE_BACKGROUND_BYTES = 512 << 20; // Edited pixels and cached outputs that background tabs may keep
+
+// The documents open in tabs, each an image with its own pipeline and history. Only the active one
+// keeps an OpenGL texture. Background documents also give up their edited pixels and cached node
+// outputs, least recently shown first, once they hold more than WORKSPACE_BACKGROUND_BYTES or the
+// memory budget runs low; both are computed again from the pipeline when the tab is shown.
+class Workspace {
+private:
+  /* Private Variables */
+  std::vector<std::unique_ptr<Image>> documents;
+  std::vector<uint64_t> lastShown; // When each document was last made active
+  std::unique_ptr<Image> blank;    // Stands in for the active document while none is open
+  size_t active;
+  uint64_t clock;
+
+public:
+  /* Constructor */
+  Workspace(void);
+
+  /* Methods */
+  void open(std::unique_ptr<Image> image);
+  void close(size_t index);
+  bool activate(size_t index);
+  void trim(void);
+
+  /* Getters */
+  std::unique_ptr<Image>& getActive(void);
+  size_t getActiveIndex(void) const;
+  std::unique_ptr<Image>& getDocument(size_t index);
+  size_t size(void) const;
+};
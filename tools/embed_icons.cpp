@@ -0,0 +1,110 @@
+// Build-time tool that decodes the icons into one RGBA atlas and writes it as a C++ header,
+// so that the editor starts without reading or decoding any files.
+// Usage: embed_icons <output.h> <icon.png>...
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cctype>
+#include <iomanip>
+#include <png.h>
+
+/* Constants */
+const int ATLAS_GAP = 2; // Transparent columns between icons, so that linear filtering does not bleed
+
+/* Icon */
+struct Icon {
+  std::string name;
+  int width;
+  int height;
+  std::vector<png_byte> pixels; // RGBA
+};
+
+// @brief: Returns the constant name of an icon, from the file name without its directory and extension
+static std::string getName(const std::string& path) {
+  size_t slash = path.find_last_of("/\\");
+  std::string stem = path.substr(slash == std::string::npos ? 0 : slash + 1);
+  stem = stem.substr(0, stem.find('.'));
+  std::string name = "ICON_";
+  for (char c : stem) name += std::isalnum(static_cast<unsigned char>(c)) ? static_cast<char>(std::toupper(static_cast<unsigned char>(c))) : '_';
+  return name;
+}
+
+// @brief: Decodes a PNG file to 8-bit RGBA
+// @return: Whether the file was decoded
+static bool decode(const std::string& path, Icon& icon) {
+  png_image image = {};
+  image.version = PNG_IMAGE_VERSION;
+  if (!png_image_begin_read_from_file(&image, path.c_str())) {
+    std::cerr << "Failed to read icon: " << path << std::endl;
+    return false;
+  }
+  image.format = PNG_FORMAT_RGBA;
+  icon.name = getName(path);
+  icon.width = static_cast<int>(image.width);
+  icon.height = static_cast<int>(image.height);
+  icon.pixels.resize(PNG_IMAGE_SIZE(image));
+  if (!png_image_finish_read(&image, nullptr, icon.pixels.data(), 0, nullptr)) {
+    std::cerr << "Failed to decode icon: " << path << " (" << image.message << ")" << std::endl;
+    png_image_free(&image);
+    return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 3) {
+    std::cerr << "Usage: " << argv[0] << " <output.h> <icon.png>..." << std::endl;
+    return 1;
+  }
+
+  // Decode the icons and lay them out left to right
+  std::vector<Icon> icons(argc - 2);
+  int width = 0;
+  int height = 0;
+  for (size_t i = 0; i < icons.size(); ++i) {
+    if (!decode(argv[i + 2], icons[i])) return 1;
+    width += (i > 0 ? ATLAS_GAP : 0) + icons[i].width;
+    height = std::max(height, icons[i].height);
+  }
+
+  std::vector<png_byte> atlas(static_cast<size_t>(width) * height * 4, 0);
+  std::vector<int> offsets;
+  int x = 0;
+  for (const Icon& icon : icons) {
+    offsets.push_back(x);
+    for (int y = 0; y < icon.height; ++y) {
+      std::copy_n(&icon.pixels[static_cast<size_t>(y) * icon.width * 4], icon.width * 4, &atlas[(static_cast<size_t>(y) * width + x) * 4]);
+    }
+    x += icon.width + ATLAS_GAP;
+  }
+
+  // Write the header
+  std::ofstream out(argv[1]);
+  if (!out) {
+    std::cerr << "Failed to open for writing: " << argv[1] << std::endl;
+    return 1;
+  }
+  out << "// Generated by embed_icons at build time. Do not edit.\n";
+  out << "#pragma once\n\n";
+  out << "/* Constants */\n";
+  out << "constexpr int ICON_ATLAS_WIDTH = " << width << ";\n";
+  out << "constexpr int ICON_ATLAS_HEIGHT = " << height << ";\n\n";
+  out << "/* Icons */\n";
+  out << std::fixed << std::setprecision(6);
+  for (size_t i = 0; i < icons.size(); ++i) {
+    out << "constexpr IconRect " << icons[i].name << " = { " << static_cast<float>(offsets[i]) / width << "f, 0.0f, "
+        << static_cast<float>(offsets[i] + icons[i].width) / width << "f, " << static_cast<float>(icons[i].height) / height << "f };\n";
+  }
+  out << "\n/* Pixels */\n";
+  out << "inline constexpr unsigned char ICON_ATLAS_PIXELS[] = {";
+  for (size_t i = 0; i < atlas.size(); ++i) out << (i % 32 == 0 ? "\n  " : "") << static_cast<int>(atlas[i]) << ",";
+  out << "\n};\n";
+  if (!out) {
+    std::cerr << "Failed to write: " << argv[1] << std::endl;
+    return 1;
+  }
+  return 0;
+}